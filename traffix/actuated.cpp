@@ -0,0 +1,183 @@
+// actuated.cpp
+
+#include "actuated.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+static const int8_t kTimer = -1;
+
+static inline bool inPhase(int d, int phase) { return (d >> 1) == phase; }
+
+static void schedule(ActuatedControl& ctl, uint32_t due, int node, int8_t kind) {
+    ActuatedEvent ev = {due, node, kind};
+    uint32_t ahead = due - ctl.now;
+    const uint32_t S = ActuatedControl::kSlots;
+    if (ahead < S) ctl.wheel[0][due & (S - 1)].push_back(ev);
+    else if (ahead < S * S) ctl.wheel[1][(due >> ActuatedControl::kWheelBits) & (S - 1)].push_back(ev);
+    else ctl.overflow.push_back(ev);
+}
+
+static void scheduleTimer(ActuatedControl& ctl, int node, uint32_t due) {
+    ActuatedNode& N = ctl.nodes[node];
+    due = max(due, ctl.now + 1);
+    // Only ever move a timer earlier; a later deadline is re-checked when the
+    // pending one fires.
+    if (N.timerDue != 0 && N.timerDue <= due) return;
+    N.timerDue = due;
+    schedule(ctl, due, node, kTimer);
+}
+
+static void scheduleArrival(ActuatedControl& ctl, Simulation& sim, int node, int d) {
+    if (!((sim.params.enabled[node] >> d) & 1u) || ctl.arrivalLog >= 0) return;
+    // Geometric inter-arrival time in whole seconds.
+    double u = (nextRand(sim.rng) + 0.5) / 4294967296.0;
+    uint32_t gap = 1 + (uint32_t)min(1e6, floor(log(u) / ctl.arrivalLog));
+    schedule(ctl, ctl.now + gap, node, (int8_t)d);
+}
+
+// Settle discharge on the green approaches up to time t.
+static void settle(ActuatedControl& ctl, Simulation& sim, int node, uint32_t t) {
+    ActuatedNode& N = ctl.nodes[node];
+    uint32_t start = max(N.lastUpdate, N.phaseStart);
+    if (t > start) {
+        Intersection& I = sim.city[node];
+        for (int d = 2 * N.phase; d < 2 * N.phase + 2; ++d) {
+            int out = serveCredit(N.credit[d], ctl.rateQ16[node * 4 + d], t - start, I.q[d]);
+            I.q[d] -= out;
+            sim.totalVehiclesServed += out;
+        }
+    }
+    N.lastUpdate = max(N.lastUpdate, t);
+}
+
+static void switchPhase(ActuatedControl& ctl, Simulation& sim, int node, int phase) {
+    ActuatedNode& N = ctl.nodes[node];
+    N.phase = (uint8_t)phase;
+    N.phaseStart = ctl.now + ctl.cfg.clearanceSec;
+    N.gapDeadline = N.phaseStart;
+    N.credit[2 * phase] = N.credit[2 * phase + 1] = 0;
+    sim.city[node].green_dir = 2 * phase;
+    N.timerDue = 0;
+    scheduleTimer(ctl, node, max(N.phaseStart + ctl.cfg.minGreen, N.holdUntil));
+}
+
+static int phaseQueue(const Simulation& sim, int node, int phase) {
+    const Intersection& I = sim.city[node];
+    return I.q[2 * phase] + I.q[2 * phase + 1];
+}
+
+static void onTimer(ActuatedControl& ctl, Simulation& sim, int node) {
+    ActuatedNode& N = ctl.nodes[node];
+    const ActuatedConfig& cfg = ctl.cfg;
+    N.timerDue = 0;
+    settle(ctl, sim, node, ctl.now);
+    if (ctl.now < N.holdUntil) { scheduleTimer(ctl, node, N.holdUntil); return; }
+    if (phaseQueue(sim, node, N.phase ^ 1) == 0) return;   // rest in green until a conflicting call
+
+    uint32_t maxEnd = N.phaseStart + cfg.maxGreen;
+    if (ctl.now >= maxEnd) { ++ctl.maxOuts; switchPhase(ctl, sim, node, N.phase ^ 1); return; }
+
+    // Time the standing queue needs to clear at the saturation rate.
+    uint32_t clearAt = ctl.now;
+    for (int d = 2 * N.phase; d < 2 * N.phase + 2; ++d) {
+        uint32_t rate = ctl.rateQ16[node * 4 + d];
+        int q = sim.city[node].q[d];
+        if (q > 0 && rate > 0) {
+            uint64_t need = ((uint64_t)q << 16) - min<uint64_t>(N.credit[d], (uint64_t)q << 16);
+            clearAt = max(clearAt, ctl.now + (uint32_t)min<uint64_t>((need + rate - 1) / rate, 1u << 30));
+        }
+    }
+    uint32_t extendTo = max(clearAt, N.gapDeadline);
+    if (extendTo <= ctl.now) { ++ctl.gapOuts; switchPhase(ctl, sim, node, N.phase ^ 1); return; }
+    scheduleTimer(ctl, node, min(extendTo, maxEnd));
+}
+
+static void onArrival(ActuatedControl& ctl, Simulation& sim, int node, int d) {
+    ActuatedNode& N = ctl.nodes[node];
+    settle(ctl, sim, node, ctl.now);
+    sim.city[node].q[d]++;
+    sim.vehiclesArrivedTotal++;
+    if (inPhase(d, N.phase)) N.gapDeadline = max(N.gapDeadline, ctl.now + ctl.cfg.passageSec);
+    else if (N.timerDue == 0) scheduleTimer(ctl, node, ctl.now + 1);   // call on a resting node
+    scheduleArrival(ctl, sim, node, d);
+}
+
+void initActuated(ActuatedControl& ctl, const Simulation& sim, const ActuatedConfig& cfg) {
+    int n = nodeCount(sim);
+    ctl.cfg = cfg;
+    ctl.now = 0;
+    ctl.nodes.assign(n, ActuatedNode());
+    ctl.rateQ16.resize((size_t)n * 4);
+    for (int i = 0; i < n * 4; ++i)
+        ctl.rateQ16[i] = (uint32_t)max(0.0, (double)sim.params.satFlow[i] * sim.params.lanes[i] * 65536.0 + 0.5);
+    for (auto& level : ctl.wheel)
+        for (auto& slot : level) slot.clear();
+    ctl.overflow.clear();
+    double p = min(1.0, 2.5 / max(1, sim.totalCycleSec));
+    ctl.arrivalLog = p >= 1.0 ? -1e300 : log(1.0 - p);
+    ctl.events = ctl.gapOuts = ctl.maxOuts = 0;
+}
+
+void actuatedPreempt(ActuatedControl& ctl, Simulation& sim, const vector<int>& path, int holdSec) {
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+        int u = path[i];
+        int d = simDirection(sim, u, path[i + 1]);
+        if (d < 0) continue;
+        ActuatedNode& N = ctl.nodes[u];
+        settle(ctl, sim, u, ctl.now);
+        uint32_t start = inPhase(d, N.phase) ? max(N.phaseStart, ctl.now) : ctl.now + ctl.cfg.clearanceSec;
+        N.holdUntil = max(N.holdUntil, start + holdSec);
+        if (!inPhase(d, N.phase)) switchPhase(ctl, sim, u, d >> 1);
+        else scheduleTimer(ctl, u, N.holdUntil);
+    }
+}
+
+void actuatedRun(ActuatedControl& ctl, Simulation& sim, int seconds) {
+    const uint32_t S = ActuatedControl::kSlots;
+    if (ctl.now == 0 && seconds > 0) {
+        // First run: start every node in N+S green and arm its detectors.
+        for (int i = 0; i < nodeCount(sim); ++i) {
+            if (ctl.nodes[i].timerDue == 0) switchPhase(ctl, sim, i, 0);
+            for (int d = 0; d < 4; ++d) scheduleArrival(ctl, sim, i, d);
+        }
+    }
+    for (int s = 0; s < seconds; ++s) {
+        ++ctl.now;
+        uint32_t now = ctl.now;
+        if ((now & (S * S - 1)) == 0) {
+            vector<ActuatedEvent> far;
+            far.swap(ctl.overflow);
+            for (const auto& ev : far) schedule(ctl, ev.due, ev.node, ev.kind);
+        }
+        if ((now & (S - 1)) == 0) {
+            auto& slot = ctl.wheel[1][(now >> ActuatedControl::kWheelBits) & (S - 1)];
+            ctl.due.swap(slot);
+            for (const auto& ev : ctl.due) schedule(ctl, ev.due, ev.node, ev.kind);
+            ctl.due.clear();
+        }
+        ctl.due.swap(ctl.wheel[0][now & (S - 1)]);
+        for (const auto& ev : ctl.due) {
+            ++ctl.events;
+            if (ev.kind == kTimer) {
+                if (ctl.nodes[ev.node].timerDue == ev.due) onTimer(ctl, sim, ev.node);
+            } else {
+                onArrival(ctl, sim, ev.node, ev.kind);
+            }
+        }
+        ctl.due.clear();
+
+        if (now % (uint32_t)max(1, sim.totalCycleSec) == 0) {
+            long long queued = 0;
+            for (int i = 0; i < nodeCount(sim); ++i) {
+                settle(ctl, sim, i, now);
+                const Intersection& I = sim.city[i];
+                queued += I.q[0] + I.q[1] + I.q[2] + I.q[3];
+            }
+            sim.cumulativeQueueSum += queued;
+            sim.cycle++;
+        }
+    }
+}
@@ -0,0 +1,134 @@
+// alt.cpp
+
+#include "alt.h"
+
+#include <algorithm>
+#include <climits>
+#include <queue>
+
+using namespace std;
+
+static const int INF = INT_MAX / 4;
+
+static void dijkstraAll(const vector<vector<Edge>>& graph, int src, int* dist) {
+    int n = graph.size();
+    fill(dist, dist + n, INF);
+    dist[src] = 0;
+    priority_queue<pair<int,int>, vector<pair<int,int>>, greater<pair<int,int>>> pq;
+    pq.push({0, src});
+    while (!pq.empty()) {
+        auto [d, u] = pq.top(); pq.pop();
+        if (d != dist[u]) continue;
+        for (const auto& e : graph[u]) {
+            if (d + e.w < dist[e.to]) {
+                dist[e.to] = d + e.w;
+                pq.push({dist[e.to], e.to});
+            }
+        }
+    }
+}
+
+void buildAltIndex(AltIndex& idx, const vector<vector<Edge>>& graph, int landmarks) {
+    int n = graph.size();
+    idx = AltIndex();
+    idx.nodes = n;
+    if (n == 0) return;
+    vector<vector<Edge>> reverse(n);
+    for (int u = 0; u < n; ++u)
+        for (const auto& e : graph[u]) {
+            reverse[e.to].push_back({u, e.w});
+            idx.maxWeight = max(idx.maxWeight, e.w);
+        }
+
+    landmarks = max(1, min(landmarks, n));
+    idx.distFrom.resize((size_t)landmarks * n);
+    idx.distTo.resize((size_t)landmarks * n);
+    // Farthest-first: each landmark maximises its distance to those chosen so
+    // far (the first is the node farthest from node 0).
+    vector<int> nearest(n, INF), scratch(n);
+    dijkstraAll(graph, 0, scratch.data());
+    int next = max_element(scratch.begin(), scratch.end(),
+                           [](int a, int b) { return (a == INF ? -1 : a) < (b == INF ? -1 : b); }) - scratch.begin();
+    for (int l = 0; l < landmarks; ++l) {
+        idx.landmarks.push_back(next);
+        int* from = &idx.distFrom[(size_t)l * n];
+        dijkstraAll(graph, next, from);
+        dijkstraAll(reverse, next, &idx.distTo[(size_t)l * n]);
+        int far = -1;
+        for (int v = 0; v < n; ++v) {
+            nearest[v] = min(nearest[v], from[v]);
+            if (nearest[v] != INF && nearest[v] > 0 && (far < 0 || nearest[v] > nearest[far])) far = v;
+        }
+        if (far < 0) break;
+        next = far;
+    }
+    int used = idx.landmarks.size();
+    idx.distFrom.resize((size_t)used * n);
+    idx.distTo.resize((size_t)used * n);
+}
+
+// Lower bound on d(v, t) in distance units.
+static inline int lowerBound(const AltIndex& idx, int v, int t) {
+    int h = 0, n = idx.nodes;
+    for (size_t l = 0; l < idx.landmarks.size(); ++l) {
+        const int* from = &idx.distFrom[l * n];
+        const int* to = &idx.distTo[l * n];
+        if (to[v] < INF && to[t] < INF) h = max(h, to[v] - to[t]);
+        if (from[t] < INF && from[v] < INF) h = max(h, from[t] - from[v]);
+    }
+    return h;
+}
+
+// A* where cost(u, e) returns the edge cost already multiplied by `scale`,
+// so the distance bound stays a lower bound.
+template <typename Cost>
+static vector<int> altSearch(const AltIndex& idx, const vector<vector<Edge>>& graph, int src, int dest,
+                             Cost cost, AltStats* stats) {
+    int n = graph.size();
+    if (src < 0 || src >= n || dest < 0 || dest >= n) return {};
+    vector<long long> g(n, LLONG_MAX);
+    vector<int> parent(n, -1);
+    vector<char> closed(n, 0);
+    priority_queue<pair<long long,int>, vector<pair<long long,int>>, greater<pair<long long,int>>> pq;
+    g[src] = 0;
+    pq.push({lowerBound(idx, src, dest), src});
+    int settled = 0;
+    while (!pq.empty()) {
+        int u = pq.top().second; pq.pop();
+        if (closed[u]) continue;
+        closed[u] = 1;
+        ++settled;
+        if (u == dest) break;
+        for (const auto& e : graph[u]) {
+            long long nd = g[u] + cost(u, e);
+            if (nd < g[e.to]) {
+                g[e.to] = nd;
+                parent[e.to] = u;
+                pq.push({nd + lowerBound(idx, e.to, dest), e.to});
+            }
+        }
+    }
+    if (stats) stats->settled = settled;
+    vector<int> path;
+    if (g[dest] == LLONG_MAX) return path;
+    for (int v = dest; v != -1; v = parent[v]) path.push_back(v);
+    reverse(path.begin(), path.end());
+    return path;
+}
+
+vector<int> altDistancePath(const AltIndex& idx, const vector<vector<Edge>>& graph, int src, int dest, AltStats* stats) {
+    return altSearch(idx, graph, src, dest, [](int, const Edge& e) { return (long long)e.w; }, stats);
+}
+
+vector<int> altCongestionPath(const AltIndex& idx, const vector<vector<Edge>>& graph, const vector<Intersection>& city,
+                              int src, int dest, AltStats* stats) {
+    long long scale = idx.maxWeight;
+    return altSearch(idx, graph, src, dest, [&](int, const Edge& e) {
+        return congestionWeight(city[e.to]) * scale;
+    }, stats);
+}
+
+vector<int> altRoute(const AltIndex& idx, const Simulation& sim, int src, int dest, bool leastCongested, AltStats* stats) {
+    if (leastCongested) return altCongestionPath(idx, sim.graph, sim.city, src, dest, stats);
+    return altDistancePath(idx, sim.graph, src, dest, stats);
+}
@@ -0,0 +1,40 @@
+// alt.h
+// ALT (A*, landmarks, triangle inequality) routing. Preprocessing picks
+// landmarks by farthest-first selection and stores the distance from and to
+// every landmark; queries are A* with the landmark lower bound
+//   h(v) = max over landmarks L of max(d(v,L) - d(t,L), d(L,t) - d(L,v)).
+// The index depends only on the graph, so it is built once and stays valid
+// while congestion changes. Congestion weights (congestionWeight, shared with
+// dijkstraCongestionPath) are never below 1, so the distance bounds remain
+// admissible for congestion queries (scaled by the largest edge weight when
+// edges are longer than 1). Both queries return the same cost as the plain
+// Dijkstra versions. Attach an index as Simulation::altIndex to have route()
+// (and everything built on it, such as the shell) use it.
+
+#pragma once
+
+#include "traffix.h"
+
+#include <vector>
+
+struct AltIndex {
+    int nodes = 0;
+    int maxWeight = 1;
+    std::vector<int> landmarks;
+    std::vector<int> distFrom;   // [l * nodes + v] = d(landmark l, v)
+    std::vector<int> distTo;     // [l * nodes + v] = d(v, landmark l)
+};
+
+struct AltStats {
+    int settled = 0;   // nodes taken off the heap
+};
+
+void buildAltIndex(AltIndex& idx, const std::vector<std::vector<Edge>>& graph, int landmarks = 8);
+std::vector<int> altDistancePath(const AltIndex& idx, const std::vector<std::vector<Edge>>& graph,
+                                 int src, int dest, AltStats* stats = nullptr);
+std::vector<int> altCongestionPath(const AltIndex& idx, const std::vector<std::vector<Edge>>& graph,
+                                   const std::vector<Intersection>& city, int src, int dest,
+                                   AltStats* stats = nullptr);
+// route() with goal-directed search.
+std::vector<int> altRoute(const AltIndex& idx, const Simulation& sim, int src, int dest,
+                          bool leastCongested = false, AltStats* stats = nullptr);
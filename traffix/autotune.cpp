@@ -0,0 +1,126 @@
+// autotune.cpp
+
+#include "autotune.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+string machineSignature() {
+    string model = "unknown";
+    ifstream cpu("/proc/cpuinfo");
+    string line;
+    while (getline(cpu, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            size_t colon = line.find(':');
+            if (colon != string::npos) model = line.substr(colon + 1);
+            break;
+        }
+    }
+    model.erase(0, model.find_first_not_of(" \t"));
+    replace(model.begin(), model.end(), ' ', '_');
+    return model + "/" + to_string(max(1u, thread::hardware_concurrency()));
+}
+
+// What the timings depend on besides the machine: grid shape, intersections
+// actually simulated (masked grids) and the engine features switched on.
+static string workloadKey(const Simulation& sim) {
+    string mode;
+    if (sim.meso.cyclesPerWeight > 0) mode += "+meso";
+    if (!sim.params.storage.empty()) mode += "+storage";
+    if (!sim.params.rateQ16.empty()) mode += "+q16";
+    return to_string(sim.R) + "x" + to_string(sim.C) + "/" + to_string(nodeCount(sim)) + "/" +
+           (mode.empty() ? "plain" : mode.substr(1));
+}
+
+// Cache lines: <machine> <workload> <threads> <grain> <cycles per second>
+static bool readCache(const string& path, const string& machine, const string& workload, TuneResult& out) {
+    ifstream f(path);
+    string line;
+    bool found = false;
+    while (getline(f, line)) {
+        istringstream ls(line);
+        string m, w;
+        TuneResult t;
+        if (!(ls >> m >> w >> t.threads >> t.grain >> t.cyclesPerSec)) continue;
+        if (m == machine && w == workload) { out = t; found = true; }   // last entry wins
+    }
+    return found;
+}
+
+static void writeCache(const string& path, const string& machine, const string& workload, const TuneResult& t) {
+    ofstream f(path, ios::app);
+    f << machine << " " << workload << " " << t.threads << " " << t.grain << " " << t.cyclesPerSec << "\n";
+}
+
+// Cycles per second of `probe` with the given settings.
+static double measure(Simulation& probe, ThreadPool* pool, int grain, double seconds) {
+    probe.pool = pool;
+    probe.grain = grain;
+    step(probe);   // warm caches and the pool
+    using clock = chrono::steady_clock;
+    auto start = clock::now();
+    int cycles = 0;
+    double elapsed = 0;
+    do {
+        step(probe);
+        ++cycles;
+        elapsed = chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < seconds && cycles < 1000);
+    return cycles / max(elapsed, 1e-9);
+}
+
+TuneResult autoTune(const Simulation& sim, const AutoTuneConfig& cfg) {
+    string machine = machineSignature(), workload = workloadKey(sim);
+    TuneResult best;
+    if (!cfg.cachePath.empty() && !cfg.refresh && readCache(cfg.cachePath, machine, workload, best)) {
+        best.fromCache = true;
+        return best;
+    }
+
+    Simulation probe = sim;
+    probe.pool = nullptr;
+    best.threads = 1;
+    best.grain = 0;
+    best.cyclesPerSec = measure(probe, nullptr, 0, cfg.secondsPerCandidate);
+
+    int n = nodeCount(sim);
+    int hw = cfg.maxThreads > 0 ? cfg.maxThreads : (int)max(1u, thread::hardware_concurrency());
+    vector<int> threadCounts;
+    for (int t = 2; t < hw; t *= 2) threadCounts.push_back(t);
+    if (hw > 1) threadCounts.push_back(hw);
+    for (int t : threadCounts) {
+        ThreadPool pool(t);
+        // automatic grain plus fixed tile sizes that still give every thread work
+        vector<int> grains = {0};
+        for (int g = 64; g * t <= n; g *= 4) grains.push_back(g);
+        for (int g : grains) {
+            double rate = measure(probe, &pool, g, cfg.secondsPerCandidate);
+            if (rate > best.cyclesPerSec) {
+                best.threads = t;
+                best.grain = g;
+                best.cyclesPerSec = rate;
+            }
+        }
+        probe.pool = nullptr;
+    }
+    if (!cfg.cachePath.empty()) writeCache(cfg.cachePath, machine, workload, best);
+    return best;
+}
+
+void applyTune(Simulation& sim, const TuneResult& tune, unique_ptr<ThreadPool>& pool) {
+    if (tune.threads > 1) {
+        if (!pool || pool->size() != tune.threads) pool.reset(new ThreadPool(tune.threads));
+        sim.pool = pool.get();
+    } else {
+        sim.pool = nullptr;
+        pool.reset();
+    }
+    sim.grain = tune.grain;
+}
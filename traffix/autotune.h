@@ -0,0 +1,36 @@
+// autotune.h
+// Startup auto-tuning of the cycle engine's execution settings. Short
+// calibration runs on a copy of the actual simulation time every candidate
+// (serial kernel, or the pooled kernel at each thread count and grain) and
+// the fastest is kept. Results are cached in a local text file keyed by
+// machine (CPU model and hardware threads) and workload (grid size, node
+// count, and whether meso links, storage limits or fixed-point service are
+// on), so later starts on the same machine and workload skip calibration.
+// All candidates produce identical results; only speed differs. The CLI's
+// shell, live and scenario modes tune at startup.
+
+#pragma once
+
+#include "traffix.h"
+
+#include <memory>
+#include <string>
+
+struct AutoTuneConfig {
+    std::string cachePath = "traffix_tune.cache";   // empty = no cache
+    int maxThreads = 0;                 // 0 = hardware concurrency
+    double secondsPerCandidate = 0.02;  // calibration time per candidate
+    bool refresh = false;               // ignore a cached entry
+};
+
+struct TuneResult {
+    int threads = 1;        // 1 = serial kernel, no pool
+    int grain = 0;          // nodes per task, 0 = automatic
+    double cyclesPerSec = 0;
+    bool fromCache = false;
+};
+
+std::string machineSignature();
+TuneResult autoTune(const Simulation& sim, const AutoTuneConfig& cfg = AutoTuneConfig());
+// Create the pool the result asks for (reset when serial) and attach it.
+void applyTune(Simulation& sim, const TuneResult& tune, std::unique_ptr<ThreadPool>& pool);
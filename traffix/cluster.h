@@ -0,0 +1,153 @@
+// cluster.h
+// Compile-time specialised engine for small fixed intersection clusters
+// (e.g. 2x2 to 4x4 roadside controllers). Grid shape is a template
+// parameter: neighbour tables are constexpr, all state lives in std::array
+// inside the object, per-node and per-lane loops are unrolled, and nothing
+// allocates. Timing is integer only (the library's splitGreenTimes and
+// serveCredit kernels, as in enableFixedPointService), so a step is
+// bit-reproducible. Work per step is bounded by constants, not by queue
+// values. splitGreenTimes on 4 approaches needs at most 3 rounding
+// corrections down and 1 up, each a 4-way scan: every rounded share
+// exceeds its exact share by less than 1 s and falls short by at most
+// 0.5 s. serveCredit and arrivals are straight-line code per approach.
+//
+// The model matches the library engine: arrivals, ambulance overrides
+// (first overridden direction wins), proportional green split, service.
+// Arrivals can come from detectors (stepWithArrivals) or from the built-in
+// generator (step).
+
+#pragma once
+
+#include "traffix.h"
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+namespace cluster_detail {
+
+template <typename F, int... I>
+constexpr void unrollImpl(F&& f, std::integer_sequence<int, I...>) {
+    (f(std::integral_constant<int, I>{}), ...);
+}
+
+// Calls f(std::integral_constant<int, i>) for i = 0 .. N-1, fully unrolled.
+template <int N, typename F>
+constexpr void unroll(F&& f) {
+    unrollImpl(f, std::make_integer_sequence<int, N>{});
+}
+
+} // namespace cluster_detail
+
+template <int R, int C>
+struct ClusterSim {
+    static_assert(R >= 1 && C >= 1 && R * C <= 64, "cluster engine is meant for small grids");
+    static constexpr int N = R * C;
+
+    // Neighbour in direction d (0=N,1=S,2=E,3=W), or -1 at the cluster edge.
+    static constexpr std::array<std::array<int8_t, 4>, N> makeNeighbours() {
+        std::array<std::array<int8_t, 4>, N> t{};
+        constexpr int ddr[4] = {-1, 1, 0, 0};
+        constexpr int ddc[4] = {0, 0, 1, -1};
+        for (int r = 0; r < R; ++r)
+            for (int c = 0; c < C; ++c)
+                for (int d = 0; d < 4; ++d) {
+                    int nr = r + ddr[d], nc = c + ddc[d];
+                    t[r * C + c][d] = (nr >= 0 && nr < R && nc >= 0 && nc < C) ? (int8_t)(nr * C + nc) : (int8_t)-1;
+                }
+        return t;
+    }
+    static constexpr std::array<std::array<int8_t, 4>, N> neighbours = makeNeighbours();
+
+    std::array<std::array<int, 4>, N> q{};
+    std::array<std::array<uint32_t, 4>, N> credit{};
+    std::array<std::array<int, 4>, N> green{};
+    std::array<int8_t, N> greenDir{};
+    std::array<uint8_t, N> overrideMask{};   // bit d = direction forced green this step
+
+    int cycleSec = 30;
+    uint32_t rateQ16 = 1u << 15;             // 0.5 vehicles per second
+    uint64_t rng = 1;
+    int cycle = 0;
+    long long arrived = 0, served = 0, cumulativeQueue = 0;
+
+    void setServiceRate(double vehiclesPerSec) { rateQ16 = (uint32_t)(vehiclesPerSec * 65536.0 + 0.5); }
+
+    // Mark the ambulance route; it applies to the next step only.
+    void setAmbulancePath(const int* path, int len) {
+        for (int i = 0; i + 1 < len; ++i) {
+            int u = path[i], v = path[i + 1];
+            for (int d = 0; d < 4; ++d)
+                if (neighbours[u][d] == v) { overrideMask[u] |= (uint8_t)(1u << d); break; }
+        }
+    }
+
+    // Unit-weight shortest path by BFS over the constexpr table. Writes up to
+    // N nodes into out and returns the length (0 if unreachable).
+    static int shortestPath(int src, int dest, std::array<int, N>& out) {
+        std::array<int8_t, N> parent{};
+        std::array<int, N> frontier{};
+        parent.fill(-2);
+        int head = 0, tail = 0;
+        frontier[tail++] = src;
+        parent[src] = -1;
+        while (head < tail) {
+            int u = frontier[head++];
+            if (u == dest) break;
+            for (int d = 0; d < 4; ++d) {
+                int v = neighbours[u][d];
+                if (v >= 0 && parent[v] == -2) { parent[v] = (int8_t)u; frontier[tail++] = v; }
+            }
+        }
+        if (parent[dest] == -2) return 0;
+        int len = 0;
+        for (int v = dest; v != -1; v = parent[v]) out[len++] = v;
+        for (int i = 0; i < len / 2; ++i) std::swap(out[i], out[len - 1 - i]);
+        return len;
+    }
+
+    // Proportional split of cycleSec through the library's integer kernel.
+    static void splitGreen(const std::array<int, 4>& qq, int T, std::array<int, 4>& times) {
+        splitGreenTimes(qq.data(), 4, T, times.data());
+    }
+
+    // One cycle with detector counts: arrivals[i][d] vehicles joined each approach.
+    void stepWithArrivals(const std::array<std::array<int, 4>, N>& arrivals) {
+        cluster_detail::unroll<N>([&](auto i) {
+            cluster_detail::unroll<4>([&](auto d) {
+                q[i][d] += arrivals[i][d];
+                arrived += arrivals[i][d];
+            });
+
+            splitGreen(q[i], cycleSec, green[i]);
+            if (overrideMask[i]) {
+                int give = __builtin_ctz(overrideMask[i]);
+                green[i] = {0, 0, 0, 0};
+                green[i][give] = cycleSec;
+                greenDir[i] = (int8_t)give;
+            } else {
+                int best = 0;
+                for (int d = 1; d < 4; ++d) if (green[i][d] > green[i][best]) best = d;
+                greenDir[i] = (int8_t)best;
+            }
+
+            cluster_detail::unroll<4>([&](auto d) {
+                int out = serveCredit(credit[i][d], rateQ16, (uint32_t)green[i][d], q[i][d]);
+                q[i][d] -= out;
+                served += out;
+            });
+            cumulativeQueue += q[i][0] + q[i][1] + q[i][2] + q[i][3];
+            overrideMask[i] = 0;
+        });
+        ++cycle;
+    }
+
+    // One cycle with arrivals drawn like the library engine (0..5 per lane).
+    void step() {
+        std::array<std::array<int, 4>, N> arrivals;
+        cluster_detail::unroll<N>([&](auto i) {
+            cluster_detail::unroll<4>([&](auto d) { arrivals[i][d] = (int)(nextRand(rng) % 6); });
+        });
+        stepWithArrivals(arrivals);
+    }
+};
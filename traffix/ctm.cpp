@@ -0,0 +1,166 @@
+// ctm.cpp
+
+#include "ctm.h"
+#include "parallel.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void buildCtm(CtmNetwork& net, const vector<vector<Edge>>& graph, const CtmConfig& cfg) {
+    net = CtmNetwork();
+    net.cfg = cfg;
+    int n = graph.size();
+    net.nodes = n;
+    net.outStart.assign(n + 1, 0);
+    for (int u = 0; u < n; ++u) net.outStart[u + 1] = net.outStart[u] + (int)graph[u].size();
+    int L = net.outStart[n];
+    net.links = L;
+    net.linkFrom.resize(L);
+    net.linkTo.resize(L);
+    net.linkRev.assign(L, -1);
+    net.firstCell.assign(L + 1, 0);
+    for (int u = 0, l = 0; u < n; ++u) {
+        for (auto &e : graph[u]) {
+            net.linkFrom[l] = u;
+            net.linkTo[l] = e.to;
+            net.firstCell[l + 1] = net.firstCell[l] + max(1, e.w * max(1, cfg.cellsPerWeight));
+            ++l;
+        }
+    }
+    for (int l = 0; l < L; ++l) {
+        int v = net.linkTo[l], u = net.linkFrom[l];
+        for (int b = net.outStart[v]; b < net.outStart[v + 1]; ++b)
+            if (net.linkTo[b] == u) { net.linkRev[l] = b; break; }
+    }
+
+    net.inStart.assign(n + 1, 0);
+    for (int l = 0; l < L; ++l) net.inStart[net.linkTo[l] + 1]++;
+    for (int v = 0; v < n; ++v) net.inStart[v + 1] += net.inStart[v];
+    net.inLinks.resize(L);
+    vector<int> fill(net.inStart.begin(), net.inStart.end() - 1);
+    for (int l = 0; l < L; ++l) net.inLinks[fill[net.linkTo[l]]++] = l;
+
+    net.cells = net.firstCell[L];
+    net.density.assign(net.cells, 0.0f);
+    net.inflow.assign(net.cells, 0.0f);
+    net.outflow.assign(net.cells, 0.0f);
+    net.interior.assign(net.cells, 1.0f);
+    for (int l = 0; l < L; ++l) net.interior[net.firstCell[l + 1] - 1] = 0.0f;
+}
+
+// Step 1: flows between consecutive cells of the same link.
+static void interiorFlows(CtmNetwork& net, int b, int e) {
+    const float Q = net.cfg.capacity, N = net.cfg.jamDensity, delta = net.cfg.waveRatio;
+    const float* __restrict n = net.density.data();
+    const float* __restrict mask = net.interior.data();
+    float* __restrict in = net.inflow.data();
+    float* __restrict out = net.outflow.data();
+    int last = min(e, net.cells - 1);
+    for (int c = b; c < last; ++c) {
+        float send = min(n[c], Q);
+        float recv = min(Q, delta * (N - n[c + 1]));
+        float y = min(send, recv) * mask[c];
+        out[c] = y;
+        in[c + 1] = y;
+    }
+    if (b == 0 && net.cells > 0) in[0] = 0.0f;
+    if (e == net.cells && net.cells > 0) out[net.cells - 1] = 0.0f;
+}
+
+// Step 2: node model. Overwrites outflow of last cells and inflow of first cells.
+static void nodeFlows(CtmNetwork& net, int vb, int ve, double& entered, double& exited) {
+    const CtmConfig &cfg = net.cfg;
+    const float Q = cfg.capacity, N = cfg.jamDensity, delta = cfg.waveRatio;
+    const float nodeQ = Q * cfg.greenRatio;
+    for (int v = vb; v < ve; ++v) {
+        int o0 = net.outStart[v], o1 = net.outStart[v + 1];
+        int outdeg = o1 - o0;
+        // Sending flow and per-target share of every incoming link.
+        float total = 0, exitFlow = 0;
+        for (int k = net.inStart[v]; k < net.inStart[v + 1]; ++k) {
+            int a = net.inLinks[k];
+            float S = min(net.density[net.firstCell[a + 1] - 1], nodeQ);
+            int targets = outdeg - (net.linkRev[a] >= 0 ? 1 : 0);
+            float share = targets > 0 ? (1.0f - cfg.exitFraction) / targets : 0.0f;
+            total += S * share;
+            exitFlow += S * (1.0f - share * targets);
+        }
+        float gen = outdeg > 0 ? cfg.demand / outdeg : 0.0f;
+        // Largest admissible common scale.
+        float theta = 1.0f;
+        for (int b = o0; b < o1; ++b) {
+            float D = total + gen;
+            int back = -1;
+            for (int k = net.inStart[v]; k < net.inStart[v + 1]; ++k)
+                if (net.linkRev[net.inLinks[k]] == b) { back = net.inLinks[k]; break; }
+            if (back >= 0) {
+                float S = min(net.density[net.firstCell[back + 1] - 1], nodeQ);
+                int targets = outdeg - 1;
+                D -= S * (targets > 0 ? (1.0f - cfg.exitFraction) / targets : 0.0f);
+            }
+            float R = min(Q, delta * (N - net.density[net.firstCell[b]]));
+            if (D > R) theta = min(theta, D > 0 ? R / D : 1.0f);
+            net.inflow[net.firstCell[b]] = D;     // scaled below
+        }
+        theta = max(0.0f, theta);
+        for (int b = o0; b < o1; ++b) net.inflow[net.firstCell[b]] *= theta;
+        for (int k = net.inStart[v]; k < net.inStart[v + 1]; ++k) {
+            int a = net.inLinks[k];
+            int c = net.firstCell[a + 1] - 1;
+            net.outflow[c] = theta * min(net.density[c], nodeQ);
+        }
+        entered += theta * gen * outdeg;
+        exited += theta * exitFlow;
+    }
+}
+
+// Step 3: conservation update.
+static void updateCells(CtmNetwork& net, int b, int e) {
+    float* __restrict n = net.density.data();
+    const float* __restrict in = net.inflow.data();
+    const float* __restrict out = net.outflow.data();
+    for (int c = b; c < e; ++c) n[c] += in[c] - out[c];
+}
+
+void ctmStep(CtmNetwork& net, int steps, ThreadPool* pool) {
+    const int grain = 1 << 14;
+    vector<double> enteredPart, exitedPart;
+    for (int s = 0; s < steps; ++s) {
+        if (pool) {
+            pool->parallelFor(net.cells, grain, [&](int b, int e) { interiorFlows(net, b, e); });
+            int chunks = (net.nodes + 4095) / 4096;
+            enteredPart.assign(chunks, 0.0);
+            exitedPart.assign(chunks, 0.0);
+            pool->parallelFor(chunks, 1, [&](int b, int e) {
+                for (int k = b; k < e; ++k)
+                    nodeFlows(net, k * 4096, min(net.nodes, (k + 1) * 4096), enteredPart[k], exitedPart[k]);
+            });
+            for (int k = 0; k < chunks; ++k) { net.entered += enteredPart[k]; net.exited += exitedPart[k]; }
+            pool->parallelFor(net.cells, grain, [&](int b, int e) { updateCells(net, b, e); });
+        } else {
+            interiorFlows(net, 0, net.cells);
+            nodeFlows(net, 0, net.nodes, net.entered, net.exited);
+            updateCells(net, 0, net.cells);
+        }
+        ++net.steps;
+    }
+}
+
+double ctmTotalVehicles(const CtmNetwork& net) {
+    double total = 0;
+    for (float x : net.density) total += x;
+    return total;
+}
+
+float ctmLinkOccupancy(const CtmNetwork& net, int link) {
+    int b = net.firstCell[link], e = net.firstCell[link + 1];
+    float sum = 0;
+    for (int c = b; c < e; ++c) sum += net.density[c];
+    return sum / ((e - b) * net.cfg.jamDensity);
+}
+
+void ctmSetLinkDensity(CtmNetwork& net, int link, float vehiclesPerCell) {
+    float x = min(max(0.0f, vehiclesPerCell), net.cfg.jamDensity);
+    for (int c = net.firstCell[link]; c < net.firstCell[link + 1]; ++c) net.density[c] = x;
+}
@@ -0,0 +1,66 @@
+// ctm.h
+// Macroscopic Cell Transmission Model (Daganzo) over the road graph, for
+// region-wide planning where per-lane counts are not needed.
+//
+// Every directed edge u -> v becomes a link of max(1, w * cellsPerWeight)
+// cells. All cells of all links live in flat float arrays (structure of
+// arrays); links are contiguous ranges. One time step is:
+//   1. interior stencil over every cell:  y = min(S(n[c]), R(n[c+1]))
+//      with S = min(n, Q) (sending) and R = min(Q, delta * (N - n)) (receiving)
+//   2. node pass: each intersection merges the sending flows of its
+//      incoming links and diverges them over its outgoing links (no U-turn,
+//      a fixed share leaves the network), scaled by one factor so that no
+//      receiving link is overfilled (FIFO node model); local demand enters
+//      the same way;
+//   3. update over every cell: n += in - out.
+// Steps 1 and 3 are branch-free unit-stride loops; each link has exactly one
+// upstream and one downstream node, so all three steps run in parallel
+// without conflicts. Flows are in vehicles per step, densities in vehicles
+// per cell; one step moves free-flow traffic one cell.
+
+#pragma once
+
+#include "traffix.h"
+
+#include <vector>
+
+class ThreadPool;
+
+struct CtmConfig {
+    int cellsPerWeight = 4;      // cells per unit of Edge::w
+    float capacity = 0.5f;       // Q: max flow per step across a cell boundary
+    float jamDensity = 2.0f;     // N: vehicles a cell can hold
+    float waveRatio = 0.5f;      // delta = w / vf, backward wave over free-flow speed (<= 1)
+    float greenRatio = 0.5f;     // share of capacity available at intersections
+    float exitFraction = 0.1f;   // share of flow through a node that leaves the network
+    float demand = 0.1f;         // vehicles per step generated at every node
+};
+
+struct CtmNetwork {
+    CtmConfig cfg;
+    int nodes = 0, links = 0, cells = 0;
+
+    // per link
+    std::vector<int> linkFrom, linkTo, linkRev;   // linkRev = opposite link or -1
+    std::vector<int> firstCell;                   // links + 1 entries
+    // per node (CSR): outgoing links are [outStart[v], outStart[v+1]) in link
+    // order; incoming link ids are inLinks[inStart[v] .. inStart[v+1])
+    std::vector<int> outStart, inStart, inLinks;
+
+    // per cell
+    std::vector<float> density, inflow, outflow;
+    std::vector<float> interior;                  // 1 if the cell has a downstream cell in its link
+
+    double entered = 0, exited = 0;
+    long long steps = 0;
+};
+
+void buildCtm(CtmNetwork& net, const std::vector<std::vector<Edge>>& graph, const CtmConfig& cfg);
+// Advance `steps` time steps; pool may be null for a serial run.
+void ctmStep(CtmNetwork& net, int steps = 1, ThreadPool* pool = nullptr);
+double ctmTotalVehicles(const CtmNetwork& net);
+// Mean density of a link as a fraction of jam density.
+float ctmLinkOccupancy(const CtmNetwork& net, int link);
+// Seed every cell of a link with a density (vehicles per cell), e.g. to
+// start from a jam and watch the shockwave.
+void ctmSetLinkDensity(CtmNetwork& net, int link, float vehiclesPerCell);
@@ -0,0 +1,81 @@
+// eta.cpp
+
+#include "eta.h"
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+using namespace std;
+
+double approachDelay(const Simulation& sim, int u, int d, const EtaConfig& cfg) {
+    const Intersection& I = sim.city[u];
+    int a = u * 4 + d;
+    double rate = (double)sim.params.satFlow[a] * sim.params.lanes[a];
+    if (rate <= 0) return numeric_limits<double>::infinity();
+    double q = I.q[d];
+    if (cfg.preempted) return q / rate;
+
+    int T = sim.params.cycleSec[u];
+    int green[4];
+    allocateGreenTimes(I, T, green, sim.params.enabled[u]);
+    if (green[d] <= 0) return numeric_limits<double>::infinity();
+    double red = T - green[d];
+    // Half a red on arrival, then one cycle per green's worth of queue.
+    return red / 2 + q / (rate * green[d]) * T;
+}
+
+static double linkSeconds(const Simulation& sim, int u, int v, const EtaConfig& cfg) {
+    for (const auto& e : sim.graph[u])
+        if (e.to == v) return e.w * cfg.secondsPerWeight;
+    return numeric_limits<double>::infinity();
+}
+
+double estimateEta(const Simulation& sim, const vector<int>& path, const EtaConfig& cfg) {
+    double eta = 0;
+    for (size_t k = 0; k + 1 < path.size(); ++k) {
+        int u = path[k], v = path[k + 1];
+        int d = simDirection(sim, u, v);
+        if (d < 0) return numeric_limits<double>::infinity();
+        eta += approachDelay(sim, u, d, cfg) + linkSeconds(sim, u, v, cfg);
+    }
+    return eta;
+}
+
+vector<int> fastestRoute(const Simulation& sim, int src, int dest, const EtaConfig& cfg, double* eta) {
+    int n = nodeCount(sim);
+    const double INF = numeric_limits<double>::infinity();
+    if (eta) *eta = INF;
+    if (src < 0 || src >= n || dest < 0 || dest >= n) return {};
+    vector<double> dist(n, INF);
+    vector<int> parent(n, -1);
+    dist[src] = 0;
+    priority_queue<pair<double,int>, vector<pair<double,int>>, greater<pair<double,int>>> pq;
+    pq.push({0.0, src});
+    while (!pq.empty()) {
+        auto [d, u] = pq.top(); pq.pop();
+        if (d != dist[u]) continue;
+        if (u == dest) break;
+        for (const auto& e : sim.graph[u]) {
+            int dir = simDirection(sim, u, e.to);
+            if (dir < 0) continue;
+            double nd = d + approachDelay(sim, u, dir, cfg) + e.w * cfg.secondsPerWeight;
+            if (nd < dist[e.to]) {
+                dist[e.to] = nd;
+                parent[e.to] = u;
+                pq.push({nd, e.to});
+            }
+        }
+    }
+    vector<int> path;
+    if (dist[dest] == INF) return path;
+    for (int v = dest; v != -1; v = parent[v]) path.push_back(v);
+    reverse(path.begin(), path.end());
+    if (eta) *eta = dist[dest];
+    return path;
+}
+
+vector<int> dispatchFastest(Simulation& sim, int src, int dest, const EtaConfig& cfg, double* eta) {
+    sim.ambulancePath = fastestRoute(sim, src, dest, cfg, eta);
+    return sim.ambulancePath;
+}
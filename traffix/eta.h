@@ -0,0 +1,31 @@
+// eta.h
+// Estimated time of arrival for emergency routes. Crossing node u towards v
+// costs the link travel time (edge weight * secondsPerWeight) plus the time
+// to discharge the queue ahead on u's approach towards v at serviceRate
+// (satFlow * lanes). With preemption the approach is green for the whole
+// cycle; without it the vehicle also waits half the red time, and the
+// queue discharges only during the approach's share of the cycle as given
+// by allocateGreenTimes. The ETA search runs Dijkstra on that cost directly,
+// so its route is never slower than the shortest or least congested one.
+
+#pragma once
+
+#include "traffix.h"
+
+#include <vector>
+
+struct EtaConfig {
+    double secondsPerWeight = 10.0;   // link travel time per unit of edge weight
+    bool preempted = true;            // the vehicle gets priority along its route
+};
+
+// Expected seconds to clear node u leaving in direction d (0=N,1=S,2=E,3=W).
+double approachDelay(const Simulation& sim, int u, int d, const EtaConfig& cfg = EtaConfig());
+// Expected seconds along path (0 for an empty or single-node path).
+double estimateEta(const Simulation& sim, const std::vector<int>& path, const EtaConfig& cfg = EtaConfig());
+// Route minimising estimateEta. If eta is given it receives the estimate.
+std::vector<int> fastestRoute(const Simulation& sim, int src, int dest, const EtaConfig& cfg = EtaConfig(),
+                              double* eta = nullptr);
+// Route an ambulance by ETA and give it priority on the next step.
+std::vector<int> dispatchFastest(Simulation& sim, int src, int dest, const EtaConfig& cfg = EtaConfig(),
+                                 double* eta = nullptr);
@@ -0,0 +1,244 @@
+// hybrid.cpp
+
+#include "hybrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// Sum of k draws of U{0..5}. Short stretches add the draws; long ones use
+// the normal approximation with the same mean (2.5 k) and variance
+// (35/12 k), clamped to the possible range, so a node leaving a long macro
+// stretch gets a queue as spread out as the micro model would give it.
+static int sumOfArrivalDraws(uint64_t& rng, int k) {
+    if (k <= 32) {
+        int sum = 0;
+        for (int j = 0; j < k; ++j) sum += nextRand(rng) % 6;
+        return sum;
+    }
+    double u1 = (nextRand(rng) + 0.5) / 4294967296.0, u2 = nextRand(rng) / 4294967296.0;
+    double z = sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+    double x = 2.5 * k + z * sqrt(35.0 / 12.0 * k);
+    return (int)min((double)5 * k, max(0.0, floor(x + 0.5)));
+}
+
+static int activeApproaches(unsigned enabled) {
+    return (int)(enabled & 1u) + ((enabled >> 1) & 1u) + ((enabled >> 2) & 1u) + ((enabled >> 3) & 1u);
+}
+
+// Advance a macro node from macroUpdatedAt to the current cycle in one update.
+static void catchUpMacro(HybridSim& h, int i) {
+    Simulation &s = h.sim;
+    int m = s.cycle - h.macroUpdatedAt[i];
+    if (m <= 0) return;
+    unsigned enabled = s.params.enabled[i];
+    int active = activeApproaches(enabled);
+    // m cycles of U{0..5} on every enabled approach.
+    int arrived = sumOfArrivalDraws(s.rng, m * active);
+    // Capacity with the cycle split evenly over the enabled approaches.
+    float perSec = 0;
+    for (int d = 0; d < 4; ++d)
+        if ((enabled >> d) & 1u) perSec += s.params.satFlow[i * 4 + d] * s.params.lanes[i * 4 + d];
+    float perCycle = active ? perSec * s.params.cycleSec[i] / active : 0.0f;
+    int capacity = (int)(perCycle * m + 1e-4f);
+
+    int &Q = h.macroQ[i];
+    Q += arrived;
+    int served = min(Q, capacity);
+    Q -= served;
+    s.vehiclesArrivedTotal += arrived;
+    s.totalVehiclesServed += served;
+    s.cumulativeQueueSum += (long long)Q * m;
+    h.macroUpdatedAt[i] = s.cycle;
+}
+
+// Split the aggregated count back over the approaches in proportion to the
+// shares left in city[i].q, largest remainder first. Exact: sums to macroQ.
+static void disaggregate(HybridSim& h, int i) {
+    Intersection &I = h.sim.city[i];
+    unsigned enabled = h.sim.params.enabled[i];
+    long long w[4], W = 0;
+    for (int d = 0; d < 4; ++d) { w[d] = ((enabled >> d) & 1u) ? I.q[d] : 0; W += w[d]; }
+    if (W == 0) {
+        for (int d = 0; d < 4; ++d) { w[d] = (enabled >> d) & 1u; W += w[d]; }
+        if (W == 0) { w[0] = W = 1; }
+    }
+    long long Q = h.macroQ[i], rem[4];
+    int assigned = 0;
+    for (int d = 0; d < 4; ++d) {
+        I.q[d] = (int)(Q * w[d] / W);
+        rem[d] = Q * w[d] % W;
+        assigned += I.q[d];
+    }
+    while (assigned < Q) {
+        int idx = 0;
+        for (int d = 1; d < 4; ++d) if (rem[d] > rem[idx]) idx = d;
+        I.q[idx]++; rem[idx] = -1; assigned++;
+    }
+}
+
+static void rebuildZone(HybridSim& h) {
+    Simulation &s = h.sim;
+    int n = nodeCount(s);
+    vector<uint8_t> next(n, 0);
+    vector<int> depth(n, -1), frontier;
+    for (auto &e : h.emergencies)
+        for (int u : e.path)
+            if (depth[u] < 0) { depth[u] = 0; frontier.push_back(u); }
+    for (size_t head = 0; head < frontier.size(); ++head) {
+        int u = frontier[head];
+        next[u] = 1;
+        if (depth[u] == h.cfg.zoneRadius) continue;
+        for (auto &e : s.graph[u])
+            if (depth[e.to] < 0) { depth[e.to] = depth[u] + 1; frontier.push_back(e.to); }
+    }
+
+    h.zoneNodes.clear();
+    h.macroNodes.clear();
+    for (int i = 0; i < n; ++i) {
+        if (next[i] && !h.inZone[i]) {          // macro -> micro
+            catchUpMacro(h, i);
+            disaggregate(h, i);
+        } else if (!next[i] && h.inZone[i]) {   // micro -> macro
+            const Intersection &I = s.city[i];
+            h.macroQ[i] = I.q[0] + I.q[1] + I.q[2] + I.q[3];
+            h.macroUpdatedAt[i] = s.cycle;
+            s.city[i].green_dir = -1;
+        }
+        h.inZone[i] = next[i];
+        (next[i] ? h.zoneNodes : h.macroNodes).push_back(i);
+    }
+    h.zoneDirty = false;
+}
+
+// Phase-level cycle of one zone node: arrivals at individual seconds, phases
+// served in N S E W order, discharge at the saturation flow.
+static void microCycle(HybridSim& h, int i) {
+    Simulation &s = h.sim;
+    Intersection &I = s.city[i];
+    unsigned enabled = s.params.enabled[i];
+    int cycleSec = max(1, s.params.cycleSec[i]);
+
+    int arrivalAt[4][5], arrivals[4];
+    for (int d = 0; d < 4; ++d) {
+        arrivals[d] = (int)(nextRand(s.rng) % 6) * ((enabled >> d) & 1u);
+        for (int k = 0; k < arrivals[d]; ++k) {
+            int t = nextRand(s.rng) % cycleSec, j = k;
+            while (j > 0 && arrivalAt[d][j - 1] > t) { arrivalAt[d][j] = arrivalAt[d][j - 1]; --j; }
+            arrivalAt[d][j] = t;
+        }
+        s.vehiclesArrivedTotal += arrivals[d];
+    }
+
+    // The controller sees the whole cycle's demand, as in the per-cycle engine.
+    Intersection demand = I;
+    for (int d = 0; d < 4; ++d) demand.q[d] += arrivals[d];
+    int green[4];
+    allocateGreenTimes(demand, cycleSec, green, enabled);
+    int giveDir = applyPriority(I, s.priorityPolicy, cycleSec, green, enabled);
+    if (giveDir >= 0) {
+        I.green_dir = giveDir;
+    } else {
+        int best = 0;
+        for (int d = 1; d < 4; ++d) if (green[d] > green[best]) best = d;
+        I.green_dir = best;
+    }
+
+    int start = 0;
+    for (int d = 0; d < 4; ++d) {
+        float rate = s.params.satFlow[i * 4 + d] * s.params.lanes[i * 4 + d];
+        int present = I.q[d], next = 0, served = 0;
+        for (int t = 0; t < cycleSec; ++t) {
+            while (next < arrivals[d] && arrivalAt[d][next] <= t) { ++present; ++next; }
+            if (t >= start && t < start + green[d]) {
+                int credit = (int)(rate * (t - start + 1) + 1e-4f);
+                served = min(credit, present);
+            }
+            h.zoneWaitVehSec += present - served;
+        }
+        I.q[d] = present - served;
+        s.totalVehiclesServed += served;
+        h.zoneServed += served;
+        start += green[d];
+    }
+    s.cumulativeQueueSum += I.q[0] + I.q[1] + I.q[2] + I.q[3];
+}
+
+void initHybrid(HybridSim& h, const SimConfig& simCfg, const HybridConfig& cfg) {
+    h = HybridSim();
+    h.cfg = cfg;
+    h.cfg.zoneRadius = max(0, cfg.zoneRadius);
+    h.cfg.macroStride = max(1, cfg.macroStride);
+    initSimulation(h.sim, simCfg);
+    int n = nodeCount(h.sim);
+    h.inZone.assign(n, 0);
+    h.macroQ.assign(n, 0);
+    h.macroUpdatedAt.assign(n, 0);
+    for (int i = 0; i < n; ++i) {
+        const Intersection &I = h.sim.city[i];
+        h.macroQ[i] = I.q[0] + I.q[1] + I.q[2] + I.q[3];
+        h.initialVehicles += h.macroQ[i];
+    }
+    h.zoneDirty = true;
+}
+
+vector<int> hybridDispatch(HybridSim& h, int src, int dest, int cycles, bool leastCongested) {
+    if (leastCongested) hybridSync(h);
+    vector<int> path = route(h.sim, src, dest, leastCongested);
+    if (!path.empty() && cycles > 0) {
+        h.emergencies.push_back({path, cycles});
+        h.zoneDirty = true;
+    }
+    return path;
+}
+
+void hybridStep(HybridSim& h, int n) {
+    Simulation &s = h.sim;
+    for (int k = 0; k < n; ++k) {
+        if (h.zoneDirty) rebuildZone(h);
+
+        for (int i : h.zoneNodes)
+            for (int d = 0; d < 4; ++d) s.city[i].priority[d] = 0;
+        for (auto &e : h.emergencies) {
+            for (size_t idx = 0; idx + 1 < e.path.size(); ++idx) {
+                int dir = simDirection(s, e.path[idx], e.path[idx + 1]);
+                if (dir >= 0) s.city[e.path[idx]].priority[dir] |= 1u << PRIO_AMBULANCE;
+            }
+        }
+        for (int i : h.zoneNodes) microCycle(h, i);
+
+        ++s.cycle;
+        if (s.cycle % h.cfg.macroStride == 0)
+            for (int i : h.macroNodes) catchUpMacro(h, i);
+
+        size_t kept = 0;
+        for (auto &e : h.emergencies)
+            if (--e.cyclesLeft > 0) h.emergencies[kept++] = move(e);
+        if (kept != h.emergencies.size()) {
+            h.emergencies.resize(kept);
+            h.zoneDirty = true;
+        }
+    }
+}
+
+void hybridSync(HybridSim& h) {
+    if (h.zoneDirty) rebuildZone(h);
+    for (int i : h.macroNodes) {
+        catchUpMacro(h, i);
+        disaggregate(h, i);
+    }
+}
+
+long long hybridQueued(const HybridSim& h) {
+    long long total = 0;
+    for (int i = 0; i < nodeCount(h.sim); ++i) {
+        const Intersection &I = h.sim.city[i];
+        total += h.inZone[i] ? (long long)I.q[0] + I.q[1] + I.q[2] + I.q[3] : h.macroQ[i];
+    }
+    return total;
+}
+
+long long hybridImbalance(const HybridSim& h) {
+    return h.initialVehicles + h.sim.vehiclesArrivedTotal - h.sim.totalVehiclesServed - hybridQueued(h);
+}
@@ -0,0 +1,57 @@
+// hybrid.h
+// Hybrid level-of-detail simulation. Every intersection runs a cheap
+// macroscopic model (one aggregated queue, advanced every `macroStride`
+// cycles in a single update) except inside a dynamic zone of `zoneRadius`
+// hops around active ambulance paths. Zone nodes run a phase-level model:
+// the cycle is played out second by second, phase by phase, with individual
+// arrival times, which yields waiting-time statistics and exact override
+// timing where they matter.
+//
+// Coupling is conservative: a node leaving the zone folds its four approach
+// queues into one count; a node entering it is first caught up to the
+// current cycle and its count is split back over the approaches by
+// largest remainder, using the last known approach shares. Vehicle totals
+// therefore satisfy initial + arrived == served + queued at every cycle
+// (see hybridImbalance).
+
+#pragma once
+
+#include "traffix.h"
+
+#include <cstdint>
+#include <vector>
+
+struct HybridConfig {
+    int zoneRadius = 2;     // hops around a path that get phase-level detail
+    int macroStride = 4;    // cycles per macroscopic update
+};
+
+struct HybridSim {
+    Simulation sim;         // graph, parameters, per-approach queues of zone nodes
+    HybridConfig cfg;
+
+    struct Emergency { std::vector<int> path; int cyclesLeft; };
+    std::vector<Emergency> emergencies;
+
+    std::vector<uint8_t> inZone;         // per node
+    std::vector<int> zoneNodes;          // compacted index lists, rebuilt on change
+    std::vector<int> macroNodes;
+    std::vector<int> macroQ;             // aggregated queue of macro nodes
+    std::vector<int> macroUpdatedAt;     // cycle the macro count is current for
+    bool zoneDirty = true;
+
+    long long initialVehicles = 0;
+    double zoneWaitVehSec = 0;           // vehicle-seconds waited inside the zone
+    long long zoneServed = 0;
+};
+
+void initHybrid(HybridSim& h, const SimConfig& simCfg, const HybridConfig& cfg);
+// Route and keep the path prioritised (and in the zone) for `cycles` cycles.
+std::vector<int> hybridDispatch(HybridSim& h, int src, int dest, int cycles, bool leastCongested = false);
+void hybridStep(HybridSim& h, int n = 1);
+// Bring every macro node up to date and write all counts into sim.city so
+// the usual views and printers show the whole network.
+void hybridSync(HybridSim& h);
+long long hybridQueued(const HybridSim& h);
+// initial + arrived - served - queued; always 0.
+long long hybridImbalance(const HybridSim& h);
@@ -0,0 +1,122 @@
+// junction.cpp
+
+#include "junction.h"
+
+#include <algorithm>
+
+using namespace std;
+
+void buildJunctionNetwork(JunctionNetwork& net, const vector<vector<Edge>>& graph,
+                          int cycleSec, double serviceRate, uint64_t seed) {
+    net = JunctionNetwork();
+    int n = graph.size();
+    net.nodes = n;
+    net.rng = seed;
+    net.laneStart.assign(n + 1, 0);
+    int maxDeg = 0;
+    for (int u = 0; u < n; ++u) {
+        net.laneStart[u + 1] = net.laneStart[u] + (int)graph[u].size();
+        maxDeg = max(maxDeg, (int)graph[u].size());
+    }
+    int lanes = net.laneStart[n];
+    net.laneTo.resize(lanes);
+    for (int u = 0; u < n; ++u)
+        for (size_t k = 0; k < graph[u].size(); ++k) net.laneTo[net.laneStart[u] + k] = graph[u][k].to;
+    net.q.assign(lanes, 0);
+    net.green.assign(lanes, 0);
+    net.credit.assign(lanes, 0);
+    net.rateQ16.assign(lanes, (uint32_t)max(0.0, serviceRate * 65536.0 + 0.5));
+    net.cycleSec.assign(n, cycleSec);
+    net.priority.assign(n, 0);
+    net.greenLane.assign(n, -1);
+    for (int l = 0; l < lanes; ++l) net.q[l] = nextRand(net.rng) % 20;
+
+    net.bucketStart.assign(maxDeg + 2, 0);
+    for (int u = 0; u < n; ++u) net.bucketStart[junctionDegree(net, u) + 1]++;
+    for (int d = 0; d <= maxDeg; ++d) net.bucketStart[d + 1] += net.bucketStart[d];
+    net.bucketNodes.resize(n);
+    vector<int> fill(net.bucketStart.begin(), net.bucketStart.end() - 1);
+    for (int u = 0; u < n; ++u) net.bucketNodes[fill[junctionDegree(net, u)]++] = u;
+}
+
+void junctionPrioritisePath(JunctionNetwork& net, const vector<int>& path) {
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+        int u = path[i];
+        for (int l = net.laneStart[u]; l < net.laneStart[u + 1]; ++l) {
+            if (net.laneTo[l] != path[i + 1] || l - net.laneStart[u] >= 32) continue;
+            if (net.priority[u] == 0) net.priorityNodes.push_back(u);
+            net.priority[u] |= 1u << (l - net.laneStart[u]);
+            break;
+        }
+    }
+}
+
+// One node of degree D (D = 0 means "read the degree at run time").
+template <int D>
+static void processNode(JunctionNetwork& net, int u, int degree, long long& arrived, long long& served,
+                        long long& queued) {
+    const int deg = D > 0 ? D : degree;
+    int base = net.laneStart[u];
+    int* q = &net.q[base];
+    int* green = &net.green[base];
+    const uint32_t* rate = &net.rateQ16[base];
+    uint32_t* credit = &net.credit[base];
+    int T = net.cycleSec[u];
+
+    for (int k = 0; k < deg; ++k) {
+        int a = nextRand(net.rng) % 6;
+        q[k] += a;
+        arrived += a;
+    }
+
+    splitGreenTimes(q, deg, T, green);
+
+    uint32_t prio = net.priority[u];
+    if (prio) {
+        int give = __builtin_ctz(prio);
+        for (int k = 0; k < deg; ++k) green[k] = k == give ? T : 0;
+        net.greenLane[u] = give;
+    } else {
+        int best = 0;
+        for (int k = 1; k < deg; ++k) if (green[k] > green[best]) best = k;
+        net.greenLane[u] = deg > 0 ? best : -1;
+    }
+
+    for (int k = 0; k < deg; ++k) {
+        int out = serveCredit(credit[k], rate[k], (uint32_t)green[k], q[k]);
+        q[k] -= out;
+        served += out;
+        queued += q[k];
+    }
+}
+
+template <int D>
+static void processBucket(JunctionNetwork& net, long long& a, long long& s, long long& q) {
+    for (int k = net.bucketStart[D]; k < net.bucketStart[D + 1]; ++k) processNode<D>(net, net.bucketNodes[k], D, a, s, q);
+}
+
+template <int... Ds>
+static void processUnrolledBuckets(JunctionNetwork& net, long long& a, long long& s, long long& q,
+                                   integer_sequence<int, Ds...>) {
+    int buckets = (int)net.bucketStart.size() - 1;   // degrees 0 .. buckets-1
+    ((Ds + 1 < buckets ? processBucket<Ds + 1>(net, a, s, q) : void()), ...);
+}
+
+void junctionStep(JunctionNetwork& net, int n) {
+    const int maxU = JunctionNetwork::kMaxUnrolledDegree;
+    for (int c = 0; c < n; ++c) {
+        long long arrived = 0, served = 0, queued = 0;
+        int buckets = (int)net.bucketStart.size() - 1;
+        processUnrolledBuckets(net, arrived, served, queued, make_integer_sequence<int, maxU>{});
+        for (int d = maxU + 1; d < buckets; ++d)
+            for (int k = net.bucketStart[d]; k < net.bucketStart[d + 1]; ++k)
+                processNode<0>(net, net.bucketNodes[k], d, arrived, served, queued);
+
+        for (int u : net.priorityNodes) net.priority[u] = 0;
+        net.priorityNodes.clear();
+        net.arrived += arrived;
+        net.served += served;
+        net.cumulativeQueue += queued;
+        ++net.cycle;
+    }
+}
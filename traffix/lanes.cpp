@@ -0,0 +1,171 @@
+// lanes.cpp
+
+#include "lanes.h"
+
+#include <algorithm>
+
+using namespace std;
+
+static const int kMov = LaneLayout::kMovements;
+
+LaneLayout standardLaneLayout(int throughLanes, bool leftPocket, bool rightPocket,
+                              double satFlow, int leftShare, int rightShare) {
+    LaneLayout L;
+    uint32_t sat = (uint32_t)max(0.0, satFlow * 65536.0 + 0.5);
+    for (int d = 0; d < 4; ++d) {
+        L.lanes[d * 3 + TURN_LEFT] = leftPocket ? 1 : 0;
+        L.lanes[d * 3 + TURN_THROUGH] = (uint8_t)min(255, max(1, throughLanes));
+        L.lanes[d * 3 + TURN_RIGHT] = rightPocket ? 1 : 0;
+        // Shares are in 1/32 units; together they cannot exceed the whole approach.
+        int left = leftPocket ? min(32, max(0, leftShare)) : 0;
+        L.turnShare[d * 3 + TURN_LEFT] = (uint8_t)left;
+        L.turnShare[d * 3 + TURN_RIGHT] = rightPocket ? (uint8_t)min(32 - left, max(0, rightShare)) : 0;
+        for (int t = 0; t < 3; ++t) L.satQ16[d * 3 + t] = sat;
+    }
+    auto bit = [](int d, int t) { return (uint16_t)(1u << (d * 3 + t)); };
+    // N=0,S=1 pair; E=2,W=3 pair. Right turns run with their own through.
+    L.phaseMask[0] = bit(0, TURN_THROUGH) | bit(0, TURN_RIGHT) | bit(1, TURN_THROUGH) | bit(1, TURN_RIGHT);
+    L.phaseMask[1] = bit(0, TURN_LEFT) | bit(1, TURN_LEFT);
+    L.phaseMask[2] = bit(2, TURN_THROUGH) | bit(2, TURN_RIGHT) | bit(3, TURN_THROUGH) | bit(3, TURN_RIGHT);
+    L.phaseMask[3] = bit(2, TURN_LEFT) | bit(3, TURN_LEFT);
+    L.phases = 4;
+    if (!leftPocket) {
+        // No protected left phases: the plan collapses to two phases.
+        L.phaseMask[1] = L.phaseMask[2];
+        L.phaseMask[2] = L.phaseMask[3] = 0;
+        L.phases = 2;
+    }
+    return L;
+}
+
+void initLaneSim(LaneSim& sim, const SimConfig& cfg) {
+    sim = LaneSim();
+    sim.R = max(1, cfg.R);
+    sim.C = max(1, cfg.C);
+    sim.cycleSec = cfg.totalCycleSec;
+    sim.rng = cfg.seed;
+    buildGridGraph(sim.R, sim.C, sim.graph);
+    sim.layouts.push_back(standardLaneLayout(2, true, true, cfg.serviceRate));
+    sim.nodes.resize(sim.R * sim.C);
+    const int queueMax = max(1, cfg.initialQueueMax);
+    for (auto& N : sim.nodes) {
+        N = LaneNode();
+        N.greenPhase = -1;
+        const LaneLayout& L = sim.layouts[0];
+        for (int m = 0; m < kMov; ++m)
+            N.q[m] = L.lanes[m] ? (int)(nextRand(sim.rng) % queueMax) : 0;
+    }
+}
+
+int addLaneLayout(LaneSim& sim, const LaneLayout& layout) {
+    // LaneNode stores the index in a byte; every approach needs through lanes
+    // to take the traffic of turns without a pocket.
+    if (sim.layouts.size() > 255 || layout.phases < 1 || layout.phases > LaneLayout::kMaxPhases) return -1;
+    for (int d = 0; d < 4; ++d)
+        if (!layout.lanes[d * 3 + TURN_THROUGH]) return -1;
+    sim.layouts.push_back(layout);
+    return (int)sim.layouts.size() - 1;
+}
+
+bool setNodeLayout(LaneSim& sim, int node, int layout) {
+    if (node < 0 || node >= (int)sim.nodes.size() || layout < 0 || layout >= (int)sim.layouts.size()) return false;
+    LaneNode& N = sim.nodes[node];
+    const LaneLayout& L = sim.layouts[layout];
+    N.layout = (uint8_t)layout;
+    // Traffic queued in a pocket that no longer exists joins the through lanes.
+    for (int d = 0; d < 4; ++d)
+        for (int t : {TURN_LEFT, TURN_RIGHT})
+            if (!L.lanes[d * 3 + t]) {
+                N.q[d * 3 + TURN_THROUGH] += N.q[d * 3 + t];
+                N.q[d * 3 + t] = 0;
+                N.credit[d * 3 + t] = 0;
+            }
+    return true;
+}
+
+int approachQueue(const LaneSim& sim, int node, int d) {
+    const int32_t* q = sim.nodes[node].q + d * 3;
+    return q[0] + q[1] + q[2];
+}
+
+void laneDispatchAmbulance(LaneSim& sim, const vector<int>& path) {
+    for (size_t i = 0; i + 1 < path.size(); ++i) {
+        int d = moveDirection(path[i], path[i + 1], sim.C);
+        if (d >= 0) sim.nodes[path[i]].override |= (uint8_t)(1u << d);
+    }
+}
+
+// Phase greens in proportion to each phase's critical demand (largest queue
+// per lane among its movements) through the shared split kernel; phases
+// without demand get no green while any other phase has some.
+static void splitPhases(const LaneLayout& L, const int32_t q[], int T, int16_t green[]) {
+    int crit[LaneLayout::kMaxPhases] = {};
+    int total = 0;
+    for (int p = 0; p < L.phases; ++p) {
+        for (int m = 0; m < kMov; ++m)
+            if ((L.phaseMask[p] >> m) & 1u && L.lanes[m])
+                crit[p] = max(crit[p], (q[m] + L.lanes[m] - 1) / L.lanes[m]);
+        total += crit[p];
+    }
+    int demand[LaneLayout::kMaxPhases], times[LaneLayout::kMaxPhases];
+    for (int p = 0; p < L.phases; ++p) demand[p] = total > 0 && crit[p] == 0 ? -1 : crit[p];
+    splitGreenTimes(demand, L.phases, T, times);
+    for (int p = 0; p < LaneLayout::kMaxPhases; ++p) green[p] = (int16_t)(p < L.phases ? times[p] : 0);
+}
+
+void laneStep(LaneSim& sim, int n) {
+    const int T = sim.cycleSec;
+    for (int c = 0; c < n; ++c) {
+        long long arrived = 0, served = 0, queued = 0;
+        for (LaneNode& N : sim.nodes) {
+            const LaneLayout& L = sim.layouts[N.layout];
+
+            // Arrivals: 0..5 per approach as in the grid engine, each vehicle
+            // assigned a movement from 5 bits of the same draw. Turns without
+            // lanes of their own queue as through traffic.
+            for (int d = 0; d < 4; ++d) {
+                uint32_t r = nextRand(sim.rng);
+                int a = r % 6;
+                r /= 6;
+                int left = L.lanes[d * 3 + TURN_LEFT] ? L.turnShare[d * 3 + TURN_LEFT] : 0;
+                int right = L.lanes[d * 3 + TURN_RIGHT] ? L.turnShare[d * 3 + TURN_RIGHT] : 0;
+                for (int v = 0; v < a; ++v, r >>= 5) {
+                    int pick = r & 31;
+                    int t = pick < left ? TURN_LEFT : pick < left + right ? TURN_RIGHT : TURN_THROUGH;
+                    N.q[d * 3 + t]++;
+                }
+                arrived += a;
+            }
+
+            splitPhases(L, N.q, T, N.green);
+            if (N.override) {
+                int d = __builtin_ctz(N.override);
+                int give = 0;
+                for (int p = 0; p < L.phases; ++p)
+                    if ((L.phaseMask[p] >> (d * 3 + TURN_THROUGH)) & 1u) { give = p; break; }
+                for (int p = 0; p < L.phases; ++p) N.green[p] = p == give ? T : 0;
+                N.override = 0;
+            }
+            int best = 0;
+            for (int p = 1; p < L.phases; ++p) if (N.green[p] > N.green[best]) best = p;
+            N.greenPhase = (int8_t)best;
+
+            for (int m = 0; m < kMov; ++m) {
+                if (!L.lanes[m]) continue;
+                int g = 0;
+                for (int p = 0; p < L.phases; ++p) g += ((L.phaseMask[p] >> m) & 1u) * N.green[p];
+                // Settling leaves only the fraction, so it fits the 16-bit field.
+                uint32_t credit = N.credit[m];
+                int out = serveCredit(credit, L.satQ16[m] * L.lanes[m], (uint32_t)g, N.q[m]);
+                N.credit[m] = (uint16_t)credit;
+                N.q[m] -= out;
+                served += out;
+                queued += N.q[m];
+            }
+        }
+        sim.arrived += arrived;
+        sim.served += served;
+        sim.cumulativeQueue += queued;
+        ++sim.cycle;
+    }
+}
@@ -0,0 +1,74 @@
+// lanes.h
+// Lane-level intersections on the grid: every approach is split into a
+// left-turn pocket, the through lanes and a right-turn pocket, each movement
+// with its own lane count, saturation flow and phase permissions.
+//
+// Movements are indexed d * 3 + turn (turn 0 = left, 1 = through,
+// 2 = right; d as elsewhere, 0=N,1=S,2=E,3=W). Geometry and signal plans
+// live in a small table of LaneLayouts that many intersections share; the
+// per-intersection state is one packed LaneNode (queues, fractional
+// service credit, phase greens) so a cycle touches a single contiguous
+// record per node. Each cycle the phases split the cycle in proportion to
+// their critical movement (largest queue per lane), and every movement is
+// served in Q16.16 for the sum of the greens of the phases that permit it,
+// carrying the fraction as enableFixedPointService does.
+
+#pragma once
+
+#include "traffix.h"
+
+#include <cstdint>
+#include <vector>
+
+enum LaneTurn { TURN_LEFT = 0, TURN_THROUGH = 1, TURN_RIGHT = 2 };
+
+struct LaneLayout {
+    static const int kMovements = 12;
+    static const int kMaxPhases = 4;
+
+    uint8_t lanes[kMovements] = {};        // 0 = no dedicated lanes for the movement
+    uint32_t satQ16[kMovements] = {};      // vehicles per second per lane, Q16.16
+    uint8_t turnShare[kMovements] = {};    // share of the approach's arrivals, 1/32 units (through takes the rest)
+    uint16_t phaseMask[kMaxPhases] = {};   // bit m = movement m may discharge in the phase
+    uint8_t phases = 0;
+};
+
+struct LaneNode {
+    int32_t q[LaneLayout::kMovements];
+    uint16_t credit[LaneLayout::kMovements];
+    int16_t green[LaneLayout::kMaxPhases];
+    uint8_t layout;
+    int8_t greenPhase;     // phase with the longest green last cycle
+    uint8_t override;      // bit d = through movement of approach d forced green this cycle
+    uint8_t pad;
+};
+
+struct LaneSim {
+    int R = 0, C = 0;
+    int cycleSec = 30;
+    std::vector<std::vector<Edge>> graph;
+    std::vector<LaneLayout> layouts;
+    std::vector<LaneNode> nodes;
+    uint64_t rng = 1;
+    int cycle = 0;
+    long long arrived = 0, served = 0, cumulativeQueue = 0;
+};
+
+// Conventional four-phase plan: NS through+right, NS protected left,
+// EW through+right, EW protected left. Movements without a pocket share the
+// through lanes (their turning traffic is queued as through traffic).
+LaneLayout standardLaneLayout(int throughLanes = 2, bool leftPocket = true, bool rightPocket = true,
+                              double satFlow = 0.5, int leftShare = 6, int rightShare = 6);
+
+// Grid with standardLaneLayout() everywhere and initial queues drawn per
+// movement from [0, initialQueueMax).
+void initLaneSim(LaneSim& sim, const SimConfig& cfg);
+// Returns the layout index, or -1 if the layout has no through lanes on some
+// approach, an invalid phase count, or the table already holds 256 layouts.
+int addLaneLayout(LaneSim& sim, const LaneLayout& layout);
+// False (nothing changed) if node or layout is out of range.
+bool setNodeLayout(LaneSim& sim, int node, int layout);
+int approachQueue(const LaneSim& sim, int node, int d);
+// Force the through phase along the route for the next cycle.
+void laneDispatchAmbulance(LaneSim& sim, const std::vector<int>& path);
+void laneStep(LaneSim& sim, int n = 1);
@@ -0,0 +1,94 @@
+// liveview.cpp
+
+#include "liveview.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ostream>
+
+using namespace std;
+
+static const char kDirChar[5] = {'N', 'S', 'E', 'W', ' '};
+static const char* const kColour[3] = {"\x1b[32m", "\x1b[33m", "\x1b[31m"};
+static const uint16_t kNoNode = 0xFFFE;   // masked-out cell
+
+void initLiveView(LiveView& view, int viewRows, int viewCols) {
+    view.rows = max(1, viewRows);
+    view.cols = max(1, viewCols);
+    view.r0 = view.c0 = 0;
+    view.shown.assign((size_t)view.rows * view.cols, LiveCell());
+    view.full = true;
+    view.statusSig = -1;
+    view.bytesWritten = 0;
+}
+
+void liveViewPan(LiveView& view, const Simulation& sim, int dRows, int dCols) {
+    int r0 = max(0, min(sim.R - view.rows, view.r0 + dRows));
+    int c0 = max(0, min(sim.C - view.cols, view.c0 + dCols));
+    if (r0 == view.r0 && c0 == view.c0) return;
+    view.r0 = r0;
+    view.c0 = c0;
+    view.full = true;
+}
+
+size_t liveViewUpdate(LiveView& view, const Simulation& sim, ostream& out) {
+    string& b = view.buf;
+    b.clear();
+    int vr = min(view.rows, sim.R - view.r0), vc = min(view.cols, sim.C - view.c0);
+    if (view.full) {
+        b += "\x1b[2J";
+        fill(view.shown.begin(), view.shown.end(), LiveCell());
+        view.statusSig = -1;
+    }
+
+    char tmp[48];
+    int curRow = -1, curCol = -1, curColour = -1;   // terminal cursor (cells) and SGR state
+    for (int r = 0; r < vr; ++r) {
+        int rowCell = (view.r0 + r) * sim.C + view.c0;
+        LiveCell* shown = &view.shown[(size_t)r * view.cols];
+        for (int c = 0; c < vc; ++c) {
+            int id = cellNode(sim, rowCell + c);
+            LiveCell cell;
+            if (id >= 0) {
+                const Intersection& I = sim.city[id];
+                int total = max(0, I.q[0] + I.q[1] + I.q[2] + I.q[3]);
+                cell.total = (uint16_t)min(total, 999);
+                cell.green = (int8_t)I.green_dir;
+                cell.colour = (uint8_t)(total * 3 < view.maxQueue ? 0 : total * 3 < 2 * view.maxQueue ? 1 : 2);
+            } else {
+                cell.total = kNoNode;
+            }
+            LiveCell& old = shown[c];
+            if (old.total == cell.total && old.green == cell.green && old.colour == cell.colour) continue;
+            old = cell;
+            if (r != curRow || c != curCol) {
+                snprintf(tmp, sizeof tmp, "\x1b[%d;%dH", r + 1, c * LiveView::kCellWidth + 1);
+                b += tmp;
+            }
+            if (cell.colour != curColour) { b += kColour[cell.colour]; curColour = cell.colour; }
+            int g = cell.green >= 0 && cell.green < 4 ? cell.green : 4;
+            if (cell.total == kNoNode) snprintf(tmp, sizeof tmp, "  .  ");
+            else snprintf(tmp, sizeof tmp, "%3d%c ", (int)cell.total, kDirChar[g]);
+            b += tmp;
+            curRow = r;
+            curCol = c + 1;
+        }
+    }
+
+    long long sig = ((long long)sim.cycle << 32) ^ ((long long)view.r0 << 16) ^ view.c0;
+    if (sig != view.statusSig) {
+        view.statusSig = sig;
+        snprintf(tmp, sizeof tmp, "\x1b[%d;1H\x1b[0m\x1b[2K", vr + 2);
+        b += tmp;
+        b += "Cycle " + to_string(sim.cycle) + "  rows " + to_string(view.r0) + "-" + to_string(view.r0 + vr - 1) +
+             "  cols " + to_string(view.c0) + "-" + to_string(view.c0 + vc - 1) + "  served " +
+             to_string(sim.totalVehiclesServed);
+        curColour = -1;
+    }
+    if (curColour >= 0) b += "\x1b[0m";
+    view.full = false;
+    out.write(b.data(), b.size());
+    out.flush();
+    view.bytesWritten += b.size();
+    return b.size();
+}
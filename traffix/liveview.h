@@ -0,0 +1,42 @@
+// liveview.h
+// Live ANSI terminal view of the grid. Each node is a fixed-width cell
+// (total queue and green direction, coloured green/yellow/red by
+// congestion). Only a viewport of the grid is drawn; panning moves it.
+// The view keeps the frame on screen and each update emits just the cells
+// that changed, with a cursor move only where the changed cells are not
+// contiguous, so output bytes follow what changed rather than grid size.
+// The first frame and frames after a pan are drawn in full.
+
+#pragma once
+
+#include "traffix.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+struct LiveCell {
+    uint16_t total = 0xFFFF;   // capped at 999; 0xFFFF = nothing drawn yet
+    int8_t green = -1;
+    uint8_t colour = 0;
+};
+
+struct LiveView {
+    static const int kCellWidth = 5;
+    int rows = 20, cols = 12;       // viewport size in nodes
+    int r0 = 0, c0 = 0;             // top-left node shown
+    int maxQueue = 40;              // total queue drawn in red
+    std::vector<LiveCell> shown;    // rows * cols, what the terminal holds
+    bool full = true;               // next update redraws everything
+    long long statusSig = -1;
+    std::string buf;
+    long long bytesWritten = 0;
+};
+
+void initLiveView(LiveView& view, int viewRows, int viewCols);
+// Move the viewport by (dRows, dCols) nodes, clamped to the grid.
+void liveViewPan(LiveView& view, const Simulation& sim, int dRows, int dCols);
+// Bring the terminal up to date with sim. Returns the bytes written.
+size_t liveViewUpdate(LiveView& view, const Simulation& sim, std::ostream& out);
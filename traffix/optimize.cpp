@@ -0,0 +1,189 @@
+// optimize.cpp
+
+#include "optimize.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+static float uniform01(uint64_t &rng) { return (nextRand(rng) >> 8) * (1.0f / 16777216.0f); }
+
+static float gaussian(uint64_t &rng) {
+    float u1 = max(uniform01(rng), 1e-7f), u2 = uniform01(rng);
+    return sqrt(-2.0f * log(u1)) * cos(6.2831853f * u2);
+}
+
+SignalPlan uniformPlan(const Simulation& sim) {
+    SignalPlan plan;
+    plan.cycleSec = sim.params.cycleSec;
+    plan.weights.assign(sim.city.size() * 4, 1.0f);
+    return plan;
+}
+
+void planGreenTimes(const SignalPlan& plan, const Simulation& sim, int node, int times[4]) {
+    const Intersection &I = sim.city[node];
+    float demand[4];
+    for (int d = 0; d < 4; ++d) demand[d] = plan.weights[node * 4 + d] * (I.q[d] + 1);
+    greenTimesFromSplits(demand, plan.cycleSec[node], times, sim.params.enabled[node]);
+}
+
+double evaluatePlan(const Simulation& start, const SignalPlan& plan, int cycles, uint64_t seed,
+                    Simulation& scratch, vector<int>& greens) {
+    scratch = start;
+    scratch.rng = seed;
+    int n = nodeCount(scratch);
+    greens.resize((size_t)n * 4);
+    double meanCycle = 0;
+    for (int i = 0; i < n; ++i) meanCycle += plan.cycleSec[i];
+    meanCycle /= max(1, n);
+    int arrivedBefore = scratch.vehiclesArrivedTotal;
+    double vehicleSec = 0;
+    for (int k = 0; k < cycles; ++k) {
+        for (int i = 0; i < n; ++i) planGreenTimes(plan, scratch, i, &greens[i * 4]);
+        int arrivedPrev = scratch.vehiclesArrivedTotal;
+        stepWithGreens(scratch, greens.data());
+        // New arrivals wait on average half a cycle; vehicles left over wait a full one more.
+        vehicleSec += (scratch.vehiclesArrivedTotal - arrivedPrev) * meanCycle * 0.5;
+        for (int i = 0; i < n; ++i) {
+            const Intersection &I = scratch.city[i];
+            vehicleSec += (double)(I.q[0] + I.q[1] + I.q[2] + I.q[3]) * plan.cycleSec[i];
+        }
+    }
+    int arrived = scratch.vehiclesArrivedTotal - arrivedBefore;
+    return arrived > 0 ? vehicleSec / arrived : 0.0;
+}
+
+// Genome layout: n cycle lengths (as float seconds) followed by n*4 log-weights.
+static SignalPlan decode(const vector<float>& g, int n, const OptimizerConfig& cfg) {
+    SignalPlan plan;
+    plan.cycleSec.resize(n);
+    plan.weights.resize((size_t)n * 4);
+    for (int i = 0; i < n; ++i)
+        plan.cycleSec[i] = min(cfg.maxCycleSec, max(cfg.minCycleSec, (int)lround(g[i])));
+    for (int i = 0; i < n * 4; ++i) plan.weights[i] = exp(g[n + i]);
+    return plan;
+}
+
+OptimizerResult optimizeSignalPlan(const Simulation& base, const OptimizerConfig& cfg) {
+    OptimizerResult res;
+    int n = nodeCount(base);
+    int P = max(2, cfg.population);
+    int elite = min(max(0, cfg.elite), P - 1);
+    int scenarios = max(1, cfg.scenarios);
+    int genes = n * 5;
+    uint64_t rng = cfg.seed;
+
+    // Warm-start checkpoint shared by every evaluation, free of the base's
+    // pending dispatches and priority calls.
+    Simulation checkpoint = base;
+    checkpoint.ambulancePath.clear();
+    checkpoint.priorityRequests.clear();
+    step(checkpoint, max(0, cfg.warmupCycles));
+
+    vector<vector<float>> pop(P, vector<float>(genes, 0.0f)), nextPop = pop;
+    float cycleRange = (float)(cfg.maxCycleSec - cfg.minCycleSec);
+    for (int p = 0; p < P; ++p) {
+        for (int i = 0; i < n; ++i) {
+            float c = (float)base.params.cycleSec[i];
+            if (p > 0) c += gaussian(rng) * cfg.mutationSigma * cycleRange;
+            pop[p][i] = min((float)cfg.maxCycleSec, max((float)cfg.minCycleSec, c));
+        }
+        for (int i = n; i < genes; ++i) pop[p][i] = p > 0 ? gaussian(rng) * cfg.mutationSigma : 0.0f;
+    }
+
+    ThreadPool pool(cfg.threads);
+    vector<Simulation> scratch(P);
+    vector<vector<int>> greens(P);
+    vector<SignalPlan> plans(P);
+    vector<double> fitness(P);
+    vector<uint64_t> seeds(scenarios);
+    vector<int> order(P);
+    vector<vector<float>> finalists;
+
+    for (int gen = 0; gen < max(1, cfg.generations); ++gen) {
+        for (auto &s : seeds) s = ((uint64_t)nextRand(rng) << 32) | nextRand(rng);
+        pool.parallelFor(P, 1, [&](int b, int e) {
+            for (int p = b; p < e; ++p) {
+                plans[p] = decode(pop[p], n, cfg);
+                double f = 0;
+                for (uint64_t s : seeds) f += evaluatePlan(checkpoint, plans[p], cfg.evalCycles, s, scratch[p], greens[p]);
+                fitness[p] = f / scenarios;
+            }
+        });
+
+        for (int p = 0; p < P; ++p) order[p] = p;
+        sort(order.begin(), order.end(), [&](int a, int b) { return fitness[a] < fitness[b]; });
+        double mean = 0;
+        for (double f : fitness) mean += f;
+        res.bestHistory.push_back(fitness[order[0]]);
+        res.meanHistory.push_back(mean / P);
+        // Elitism usually carries the winner over unchanged; keep it once.
+        if (find(finalists.begin(), finalists.end(), pop[order[0]]) == finalists.end())
+            finalists.push_back(pop[order[0]]);
+
+        for (int p = 0; p < elite; ++p) nextPop[p] = pop[order[p]];
+        auto tournament = [&]() {
+            int a = nextRand(rng) % P, b = nextRand(rng) % P;
+            return fitness[a] < fitness[b] ? a : b;
+        };
+        for (int p = elite; p < P; ++p) {
+            const vector<float> &ma = pop[tournament()], &pa = pop[tournament()];
+            vector<float> &child = nextPop[p];
+            for (int g = 0; g < genes; ++g) {
+                float t = uniform01(rng);
+                child[g] = ma[g] + t * (pa[g] - ma[g]);
+                if (uniform01(rng) < cfg.mutationRate) {
+                    float sigma = g < n ? cfg.mutationSigma * cycleRange : cfg.mutationSigma;
+                    child[g] += gaussian(rng) * sigma;
+                }
+                if (g < n) child[g] = min((float)cfg.maxCycleSec, max((float)cfg.minCycleSec, child[g]));
+            }
+        }
+        swap(pop, nextPop);
+    }
+
+    // Compare the generation winners on the same validation seeds.
+    vector<uint64_t> validation(max(1, cfg.validationScenarios));
+    for (auto &s : validation) s = ((uint64_t)nextRand(rng) << 32) | nextRand(rng);
+    int F = finalists.size();
+    vector<double> score(F);
+    scratch.resize(max(P, F));
+    greens.resize(max(P, F));
+    plans.resize(max(P, F));
+    pool.parallelFor(F, 1, [&](int b, int e) {
+        for (int f = b; f < e; ++f) {
+            plans[f] = decode(finalists[f], n, cfg);
+            double total = 0;
+            for (uint64_t s : validation) total += evaluatePlan(checkpoint, plans[f], cfg.evalCycles, s, scratch[f], greens[f]);
+            score[f] = total / validation.size();
+        }
+    });
+    int best = min_element(score.begin(), score.end()) - score.begin();
+    res.best = plans[best];
+    res.bestFitness = score[best];
+    return res;
+}
+
+void printOptimizerReport(ostream& out, const OptimizerResult& res, const Simulation& sim) {
+    out << "\n=== Signal Plan Optimisation ===\n";
+    out << "Generation  best delay (s)  mean delay (s)\n";
+    for (size_t g = 0; g < res.bestHistory.size(); ++g) {
+        out << setw(10) << g + 1 << "  " << setw(14) << fixed << setprecision(2) << res.bestHistory[g]
+            << "  " << setw(14) << res.meanHistory[g] << "\n";
+    }
+    out << "Best mean delay (validation): " << fixed << setprecision(2) << res.bestFitness << " s\n";
+    if (res.best.cycleSec.empty()) return;
+    out << "Best plan (cycle s; weights N S E W):\n";
+    int n = min(nodeCount(sim), (int)res.best.cycleSec.size());
+    for (int id = 0; id < n; ++id) {
+        const float* w = &res.best.weights[id * 4];
+        out << "[Node " << id << "] " << res.best.cycleSec[id] << "s (" << setprecision(2)
+            << w[0] << " " << w[1] << " " << w[2] << " " << w[3] << ")  ";
+        if (id + 1 == n || nodeCell(sim, id + 1) / sim.C != nodeCell(sim, id) / sim.C) out << "\n";
+    }
+    out << "================================\n";
+}
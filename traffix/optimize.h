@@ -0,0 +1,60 @@
+// optimize.h
+// Signal-plan optimiser: a real-coded genetic algorithm over per-intersection
+// timing parameters, using short simulations as the fitness function.
+//
+// A plan gives every node a cycle length and a weight per approach; each
+// cycle the green split is proportional to weight * (queue + 1). Fitness is
+// the mean vehicle delay in seconds (half a cycle for every arrival plus a
+// full cycle for every vehicle left queued, divided by arrivals), so longer
+// cycles trade capacity for waiting time. Candidates are evaluated in parallel from one warmed-up
+// checkpoint, and all candidates of a generation share the same random
+// seeds (common random numbers) so differences reflect the plan, not noise.
+// Seeds change between generations, so generation scores are not comparable
+// with each other: every generation's winner becomes a finalist, and the
+// result is the finalist with the lowest delay on one fixed set of
+// validation seeds.
+
+#pragma once
+
+#include "traffix.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+struct SignalPlan {
+    std::vector<int> cycleSec;     // per node
+    std::vector<float> weights;    // per node * 4 (N S E W)
+};
+
+struct OptimizerConfig {
+    int population = 32;
+    int generations = 25;
+    int elite = 2;
+    int warmupCycles = 20;   // simulated once; every evaluation starts here
+    int evalCycles = 20;
+    int scenarios = 2;       // common-random-number seeds per generation
+    int validationScenarios = 4;   // fixed seeds the finalists are compared on
+    int minCycleSec = 10, maxCycleSec = 120;
+    float mutationRate = 0.2f;   // per gene
+    float mutationSigma = 0.3f;  // in log-weight units; scaled to the cycle range
+    uint64_t seed = 1;
+    int threads = 0;
+};
+
+struct OptimizerResult {
+    SignalPlan best;
+    double bestFitness = 0;            // validation delay of best
+    std::vector<double> bestHistory;   // per generation, on that generation's seeds
+    std::vector<double> meanHistory;
+};
+
+// Plan reproducing the simulation's current cycle lengths with neutral weights.
+SignalPlan uniformPlan(const Simulation& sim);
+void planGreenTimes(const SignalPlan& plan, const Simulation& sim, int node, int times[4]);
+// Mean delay (s) of the plan over `cycles`, starting from a copy of `start`
+// with its random stream reseeded. `scratch` and `greens` are reused buffers.
+double evaluatePlan(const Simulation& start, const SignalPlan& plan, int cycles, uint64_t seed,
+                    Simulation& scratch, std::vector<int>& greens);
+OptimizerResult optimizeSignalPlan(const Simulation& base, const OptimizerConfig& cfg);
+void printOptimizerReport(std::ostream& out, const OptimizerResult& res, const Simulation& sim);
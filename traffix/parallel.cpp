@@ -0,0 +1,72 @@
+// parallel.cpp
+
+#include "parallel.h"
+
+using namespace std;
+
+// Set while a thread executes pool work; nested parallelFor calls (e.g. a
+// simulation with a pool stepped inside an optimiser task) then run inline.
+static thread_local bool insidePool = false;
+
+ThreadPool::ThreadPool(int threads) {
+    if (threads <= 0) threads = (int)thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+    for (int i = 1; i < threads; ++i) workers.emplace_back([this] { workLoop(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> lk(m);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &t : workers) t.join();
+}
+
+void ThreadPool::drain() {
+    for (;;) {
+        int b = next.fetch_add(taskGrain, memory_order_relaxed);
+        if (b >= taskCount) return;
+        int e = b + taskGrain < taskCount ? b + taskGrain : taskCount;
+        task(taskCtx, b, e);
+    }
+}
+
+void ThreadPool::run(int count, int grain, Task fn, void* ctx) {
+    if (count <= 0) return;
+    if (grain < 1) grain = 1;
+    if (workers.empty() || count <= grain || insidePool) { fn(ctx, 0, count); return; }
+    {
+        lock_guard<mutex> lk(m);
+        task = fn; taskCtx = ctx;
+        taskCount = count; taskGrain = grain;
+        next.store(0, memory_order_relaxed);
+        pending = (int)workers.size();
+        ++generation;
+    }
+    wake.notify_all();
+    insidePool = true;
+    drain();
+    insidePool = false;
+    unique_lock<mutex> lk(m);
+    done.wait(lk, [this] { return pending == 0; });
+}
+
+void ThreadPool::workLoop() {
+    unsigned seen = 0;
+    for (;;) {
+        {
+            unique_lock<mutex> lk(m);
+            wake.wait(lk, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        insidePool = true;
+        drain();
+        insidePool = false;
+        {
+            lock_guard<mutex> lk(m);
+            if (--pending == 0) done.notify_one();
+        }
+    }
+}
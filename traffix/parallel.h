@@ -0,0 +1,56 @@
+// parallel.h
+// Persistent worker pool for the data-parallel loops in libtraffix.
+// Workers are created once; parallelFor hands out [begin, end) chunks of
+// `grain` items through an atomic counter and the calling thread joins in.
+// Submitting work allocates nothing. Calls made from inside a running task
+// execute inline on the calling thread.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool {
+public:
+    // threads = total workers including the caller; 0 = hardware concurrency.
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return (int)workers.size() + 1; }
+
+    // body(begin, end) is called for disjoint chunks covering [0, count).
+    template <typename F>
+    void parallelFor(int count, int grain, F&& body) {
+        using Fn = typename std::remove_reference<F>::type;
+        run(count, grain, [](void* ctx, int b, int e) { (*static_cast<Fn*>(ctx))(b, e); }, &body);
+    }
+    template <typename F>
+    void parallelFor(int count, F&& body) {
+        int g = (count + size() * 4 - 1) / (size() * 4);
+        parallelFor(count, g < 1 ? 1 : g, body);
+    }
+
+private:
+    using Task = void (*)(void*, int, int);
+    void run(int count, int grain, Task fn, void* ctx);
+    void workLoop();
+    void drain();
+
+    std::vector<std::thread> workers;
+    std::mutex m;
+    std::condition_variable wake, done;
+    unsigned generation = 0;
+    int pending = 0;
+    bool stopping = false;
+
+    Task task = nullptr;
+    void* taskCtx = nullptr;
+    int taskCount = 0, taskGrain = 1;
+    std::atomic<int> next{0};
+};
@@ -0,0 +1,162 @@
+// publish.cpp
+
+#include "publish.h"
+
+#include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static size_t roundUp(size_t x, size_t a) { return (x + a - 1) / a * a; }
+
+static string shmName(const string& name) { return name.empty() || name[0] != '/' ? "/" + name : name; }
+
+static ShmFrame* frameAt(void* base, uint32_t offset) { return (ShmFrame*)((char*)base + offset); }
+
+// Every read beginRead and the frame accessors make stays inside the mapping.
+static bool layoutFits(const ShmHeader* h, size_t bytes) {
+    if (h->nodes < 0 || h->frameBytes < sizeof(ShmFrame)) return false;
+    const size_t n = h->nodes;
+    for (int k = 0; k < 2; ++k) {
+        size_t off = h->frameOffset[k];
+        if (off % alignof(ShmFrame) || off < sizeof(ShmHeader) || off + h->frameBytes > bytes) return false;
+        const ShmFrame* f = (const ShmFrame*)((const char*)h + off);
+        if (f->queueOffset < sizeof(ShmFrame) || f->queueOffset % alignof(int32_t) ||
+            f->queueOffset + n * 4 * sizeof(int32_t) > h->frameBytes) return false;
+        if (f->greenOffset < sizeof(ShmFrame) || f->greenOffset + n > h->frameBytes) return false;
+        if (f->priorityOffset < sizeof(ShmFrame) || f->priorityOffset + n * 4 > h->frameBytes) return false;
+    }
+    return true;
+}
+
+bool openPublisher(ShmPublisher& pub, const string& name, const Simulation& sim) {
+    closePublisher(pub, false);
+    int n = nodeCount(sim);
+    size_t queueOff = roundUp(sizeof(ShmFrame), 64);
+    size_t greenOff = roundUp(queueOff + (size_t)n * 4 * sizeof(int32_t), 64);
+    size_t prioOff = roundUp(greenOff + (size_t)n, 64);
+    size_t frameBytes = roundUp(prioOff + (size_t)n * 4, 64);
+    size_t first = roundUp(sizeof(ShmHeader), 64);
+    size_t bytes = first + 2 * frameBytes;
+
+    string path = shmName(name);
+    int fd = shm_open(path.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) return false;
+    if (ftruncate(fd, (off_t)bytes) != 0) { close(fd); return false; }
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return false;
+
+    memset(base, 0, bytes);
+    ShmHeader* h = new (base) ShmHeader;
+    h->version = ShmHeader::kVersion;
+    h->R = sim.R;
+    h->C = sim.C;
+    h->nodes = n;
+    h->frameBytes = (uint32_t)frameBytes;
+    for (int k = 0; k < 2; ++k) {
+        h->frameOffset[k] = (uint32_t)(first + k * frameBytes);
+        ShmFrame* f = new (frameAt(base, h->frameOffset[k])) ShmFrame;
+        f->seq.store(0, memory_order_relaxed);
+        f->cycle = -1;
+        f->queueOffset = (uint32_t)queueOff;
+        f->greenOffset = (uint32_t)greenOff;
+        f->priorityOffset = (uint32_t)prioOff;
+    }
+    h->current.store(0, memory_order_relaxed);
+    // Readers check the magic last, so a half-initialised segment is never used.
+    atomic_thread_fence(memory_order_release);
+    h->magic = ShmHeader::kMagic;
+
+    pub.name = path;
+    pub.base = base;
+    pub.bytes = bytes;
+    publishState(pub, sim);
+    return true;
+}
+
+void publishState(ShmPublisher& pub, const Simulation& sim) {
+    if (!pub.base) return;
+    ShmHeader* h = (ShmHeader*)pub.base;
+    int n = min(h->nodes, nodeCount(sim));
+    uint32_t next = h->current.load(memory_order_relaxed) ^ 1u;
+    ShmFrame* f = frameAt(pub.base, h->frameOffset[next]);
+
+    uint32_t s = f->seq.load(memory_order_relaxed);
+    f->seq.store(s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    int32_t* q = (int32_t*)((char*)f + f->queueOffset);
+    int8_t* g = (int8_t*)((char*)f + f->greenOffset);
+    uint8_t* p = (uint8_t*)((char*)f + f->priorityOffset);
+    for (int i = 0; i < n; ++i) {
+        const Intersection& I = sim.city[i];
+        memcpy(q + i * 4, I.q, 4 * sizeof(int32_t));
+        g[i] = (int8_t)I.green_dir;
+        memcpy(p + i * 4, I.priority, 4);
+    }
+    f->cycle = sim.cycle;
+
+    f->seq.store(s + 2, memory_order_release);
+    h->current.store(next, memory_order_release);
+}
+
+void closePublisher(ShmPublisher& pub, bool unlink) {
+    if (pub.base) munmap(pub.base, pub.bytes);
+    if (unlink && !pub.name.empty()) shm_unlink(pub.name.c_str());
+    pub = ShmPublisher();
+}
+
+bool openReader(ShmReader& reader, const string& name) {
+    closeReader(reader);
+    int fd = shm_open(shmName(name).c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ShmHeader)) { close(fd); return false; }
+    void* base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return false;
+    const ShmHeader* h = (const ShmHeader*)base;
+    if (h->magic != ShmHeader::kMagic || h->version != ShmHeader::kVersion) {
+        munmap(base, st.st_size);
+        return false;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    if (!layoutFits(h, st.st_size)) {
+        munmap(base, st.st_size);
+        return false;
+    }
+    reader.base = base;
+    reader.bytes = st.st_size;
+    return true;
+}
+
+void closeReader(ShmReader& reader) {
+    if (reader.base) munmap(reader.base, reader.bytes);
+    reader = ShmReader();
+}
+
+const ShmFrame* beginRead(const ShmReader& reader, uint32_t& seq) {
+    const ShmHeader* h = readerHeader(reader);
+    if (!h) return nullptr;
+    // A publish takes one pass over the queues; a frame that stays odd for
+    // this many looks belongs to a publisher that died mid-write.
+    const int kMaxTries = 4096;
+    for (int t = 0; t < kMaxTries; ++t) {
+        uint32_t k = h->current.load(memory_order_acquire) & 1u;
+        const ShmFrame* f = (const ShmFrame*)((const char*)reader.base + h->frameOffset[k]);
+        seq = f->seq.load(memory_order_acquire);
+        if (!(seq & 1u)) return f;
+        this_thread::yield();
+    }
+    return nullptr;
+}
+
+bool endRead(const ShmFrame* frame, uint32_t seq) {
+    atomic_thread_fence(memory_order_acquire);
+    return frame->seq.load(memory_order_relaxed) == seq;
+}
@@ -0,0 +1,79 @@
+// publish.h
+// Live state in POSIX shared memory for local viewers and monitors.
+//
+// The segment holds a header and two frames. Each frame carries the cycle
+// number, the queues (node * 4 + d), green directions and per-approach
+// priority masks. The publisher always writes the frame readers are not
+// pointed at, under that frame's sequence counter (odd while writing), then
+// flips `current`. Readers map the segment read-only and read a frame in
+// place: beginRead returns the current frame and its sequence, endRead
+// confirms nothing was rewritten meanwhile. Readers never block the
+// simulation thread; a reader slower than a whole cycle simply retries.
+//
+// POSIX only (shm_open/mmap); on older glibc link with -lrt.
+
+#pragma once
+
+#include "traffix.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared-memory counters must be lock free");
+
+struct ShmFrame {
+    alignas(64) std::atomic<uint32_t> seq;
+    int64_t cycle;
+    uint32_t queueOffset, greenOffset, priorityOffset;   // bytes from the frame start
+};
+
+struct ShmHeader {
+    static const uint32_t kMagic = 0x58464654;   // "TFFX"
+    static const uint32_t kVersion = 1;
+    uint32_t magic, version;
+    int32_t R, C, nodes;
+    uint32_t frameBytes;
+    uint32_t frameOffset[2];                      // bytes from the segment start
+    alignas(64) std::atomic<uint32_t> current;    // frame readers should use
+};
+
+struct ShmPublisher {
+    std::string name;
+    void* base = nullptr;
+    size_t bytes = 0;
+};
+
+struct ShmReader {
+    void* base = nullptr;
+    size_t bytes = 0;
+};
+
+inline const int32_t* frameQueues(const ShmFrame* f) {
+    return (const int32_t*)((const char*)f + f->queueOffset);
+}
+inline const int8_t* frameGreens(const ShmFrame* f) {
+    return (const int8_t*)((const char*)f + f->greenOffset);
+}
+inline const uint8_t* framePriority(const ShmFrame* f) {
+    return (const uint8_t*)((const char*)f + f->priorityOffset);
+}
+
+// Create (or replace) the segment /name sized for the simulation's grid.
+bool openPublisher(ShmPublisher& pub, const std::string& name, const Simulation& sim);
+// Publish the state after a step. Cost: one pass over the queue arrays.
+void publishState(ShmPublisher& pub, const Simulation& sim);
+void closePublisher(ShmPublisher& pub, bool unlink = true);
+
+// Fails unless the segment is a complete one from openPublisher whose frame
+// layout fits the mapped size.
+bool openReader(ShmReader& reader, const std::string& name);
+void closeReader(ShmReader& reader);
+inline const ShmHeader* readerHeader(const ShmReader& reader) { return (const ShmHeader*)reader.base; }
+// Zero-copy snapshot: read the frame's arrays between beginRead and endRead;
+// if endRead returns false the frame was overwritten and must be re-read.
+// beginRead returns nullptr when no frame settles after a bounded number of
+// retries, i.e. the publisher stopped in the middle of a write.
+const ShmFrame* beginRead(const ShmReader& reader, uint32_t& seq);
+bool endRead(const ShmFrame* frame, uint32_t seq);
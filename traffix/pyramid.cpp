@@ -0,0 +1,224 @@
+// pyramid.cpp
+
+#include "pyramid.h"
+
+#include <algorithm>
+#include <climits>
+#include <queue>
+
+using namespace std;
+
+static inline int cellWeight(const Simulation& sim, int cell) {
+    int u = cellNode(sim, cell);
+    if (u < 0) return INT_MAX;
+    return congestionWeight(sim.city[u]);
+}
+
+// Recompute block b of level k from its four children.
+static bool recomputeBlock(CongestionPyramid& pyr, int k, int b) {
+    const PyramidLevel& lo = pyr.levels[k - 1];
+    PyramidLevel& L = pyr.levels[k];
+    int r = b / L.cols, c = b % L.cols;
+    long long sum = 0;
+    int mn = INT_MAX, cnt = 0;
+    for (int dy = 0; dy < 2; ++dy)
+        for (int dx = 0; dx < 2; ++dx) {
+            int rr = 2 * r + dy, cc = 2 * c + dx;
+            if (rr >= lo.rows || cc >= lo.cols) continue;
+            int child = rr * lo.cols + cc;
+            sum += lo.sum[child];
+            mn = min(mn, lo.minCost[child]);
+            cnt += lo.count[child];
+        }
+    bool changed = sum != L.sum[b] || mn != L.minCost[b] || cnt != L.count[b];
+    L.sum[b] = sum;
+    L.minCost[b] = mn;
+    L.count[b] = cnt;
+    return changed;
+}
+
+void buildPyramid(CongestionPyramid& pyr, const Simulation& sim) {
+    pyr = CongestionPyramid();
+    pyr.R = sim.R;
+    pyr.C = sim.C;
+    PyramidLevel base;
+    base.rows = sim.R;
+    base.cols = sim.C;
+    int cells = sim.R * sim.C;
+    base.sum.resize(cells);
+    base.minCost.resize(cells);
+    base.count.resize(cells);
+    for (int cell = 0; cell < cells; ++cell) {
+        int w = cellWeight(sim, cell);
+        bool node = w != INT_MAX;
+        base.sum[cell] = node ? w : 0;
+        base.minCost[cell] = w;
+        base.count[cell] = node;
+    }
+    pyr.levels.push_back(base);
+    while (pyr.levels.back().rows > 1 || pyr.levels.back().cols > 1) {
+        const PyramidLevel& lo = pyr.levels.back();
+        PyramidLevel L;
+        L.rows = (lo.rows + 1) / 2;
+        L.cols = (lo.cols + 1) / 2;
+        L.sum.assign((size_t)L.rows * L.cols, -1);
+        L.minCost.assign(L.sum.size(), 0);
+        L.count.assign(L.sum.size(), 0);
+        pyr.levels.push_back(L);
+        int k = pyr.levels.size() - 1;
+        for (int b = 0; b < L.rows * L.cols; ++b) recomputeBlock(pyr, k, b);
+    }
+    pyr.queued.assign(pyr.levels.size() > 1 ? pyr.levels[1].sum.size() : 0, 0);
+}
+
+int updatePyramid(CongestionPyramid& pyr, const Simulation& sim) {
+    PyramidLevel& base = pyr.levels[0];
+    int changed = 0;
+    pyr.dirty.clear();
+    bool hasParent = pyr.levels.size() > 1;
+    int parentCols = hasParent ? pyr.levels[1].cols : 0;
+    for (int cell = 0; cell < base.rows * base.cols; ++cell) {
+        int w = cellWeight(sim, cell);
+        if (w == base.minCost[cell]) continue;
+        base.minCost[cell] = w;
+        base.sum[cell] = w == INT_MAX ? 0 : w;
+        ++changed;
+        if (!hasParent) continue;
+        int p = (cell / base.cols / 2) * parentCols + (cell % base.cols) / 2;
+        if (!pyr.queued[p]) { pyr.queued[p] = 1; pyr.dirty.push_back(p); }
+    }
+    // Only blocks above changed cells are recomputed, level by level.
+    for (size_t k = 1; k < pyr.levels.size() && !pyr.dirty.empty(); ++k) {
+        pyr.nextDirty.clear();
+        bool up = k + 1 < pyr.levels.size();
+        int cols = pyr.levels[k].cols, upCols = up ? pyr.levels[k + 1].cols : 0;
+        for (int b : pyr.dirty) {
+            if (k == 1) pyr.queued[b] = 0;
+            ++pyr.blocksUpdated;
+            if (recomputeBlock(pyr, k, b) && up) pyr.nextDirty.push_back((b / cols / 2) * upCols + (b % cols) / 2);
+        }
+        sort(pyr.nextDirty.begin(), pyr.nextDirty.end());
+        pyr.nextDirty.erase(unique(pyr.nextDirty.begin(), pyr.nextDirty.end()), pyr.nextDirty.end());
+        pyr.dirty.swap(pyr.nextDirty);
+    }
+    return changed;
+}
+
+// Dijkstra over the blocks of one level; entering block b costs cost(b).
+// Returns the block path (empty if none).
+template <typename Cost>
+static vector<int> blockSearch(const PyramidLevel& L, int from, int to, Cost cost, long long* total) {
+    int n = L.rows * L.cols;
+    vector<long long> dist(n, LLONG_MAX);
+    vector<int> parent(n, -1);
+    priority_queue<pair<long long,int>, vector<pair<long long,int>>, greater<pair<long long,int>>> pq;
+    dist[from] = 0;
+    pq.push({0, from});
+    while (!pq.empty()) {
+        auto [d, b] = pq.top(); pq.pop();
+        if (d != dist[b]) continue;
+        if (b == to) break;
+        int r = b / L.cols, c = b % L.cols;
+        for (int dd = 0; dd < 4; ++dd) {
+            int nr = r + dr[dd], nc = c + dc[dd];
+            if (nr < 0 || nr >= L.rows || nc < 0 || nc >= L.cols) continue;
+            int v = nr * L.cols + nc;
+            if (L.count[v] == 0) continue;
+            long long nd = d + cost(v);
+            if (nd < dist[v]) { dist[v] = nd; parent[v] = b; pq.push({nd, v}); }
+        }
+    }
+    vector<int> path;
+    if (dist[to] == LLONG_MAX) return path;
+    if (total) *total = dist[to];
+    for (int b = to; b != -1; b = parent[b]) path.push_back(b);
+    reverse(path.begin(), path.end());
+    return path;
+}
+
+// Exact congestion search restricted to nodes whose level-k block is allowed.
+static vector<int> corridorSearch(const Simulation& sim, int src, int dest, int k, int blockCols,
+                                  const vector<uint8_t>& allowed, long long* cost, int* settled) {
+    int n = nodeCount(sim);
+    auto inCorridor = [&](int u) {
+        int cell = nodeCell(sim, u);
+        return allowed[((cell / sim.C) >> k) * blockCols + ((cell % sim.C) >> k)] != 0;
+    };
+    vector<long long> dist(n, LLONG_MAX);
+    vector<int> parent(n, -1);
+    priority_queue<pair<long long,int>, vector<pair<long long,int>>, greater<pair<long long,int>>> pq;
+    dist[src] = 0;
+    pq.push({0, src});
+    int count = 0;
+    while (!pq.empty()) {
+        auto [d, u] = pq.top(); pq.pop();
+        if (d != dist[u]) continue;
+        ++count;
+        if (u == dest) break;
+        for (const auto& e : sim.graph[u]) {
+            int v = e.to;
+            if (!inCorridor(v)) continue;
+            long long nd = d + congestionWeight(sim.city[v]);
+            if (nd < dist[v]) { dist[v] = nd; parent[v] = u; pq.push({nd, v}); }
+        }
+    }
+    *settled += count;
+    vector<int> path;
+    if (dist[dest] == LLONG_MAX) return path;
+    *cost = dist[dest];
+    for (int v = dest; v != -1; v = parent[v]) path.push_back(v);
+    reverse(path.begin(), path.end());
+    return path;
+}
+
+vector<int> hierarchicalRoute(const CongestionPyramid& pyr, const Simulation& sim, int src, int dest,
+                              HierRouteReport* report, int level, int margin) {
+    HierRouteReport rep;
+    int n = nodeCount(sim);
+    if (src < 0 || src >= n || dest < 0 || dest >= n || pyr.levels.empty()) return {};
+    int top = pyr.levels.size() - 1;
+    if (level < 0) {
+        level = 0;
+        while (level < top && max(pyr.levels[level].rows, pyr.levels[level].cols) > 32) ++level;
+    }
+    level = min(level, top);
+    const PyramidLevel& L = pyr.levels[level];
+    int srcCell = nodeCell(sim, src), destCell = nodeCell(sim, dest);
+    auto blockOf = [&](int cell) { return ((cell / sim.C) >> level) * L.cols + ((cell % sim.C) >> level); };
+    int side = 1 << level;
+
+    // Coarse corridor: mean weight of a block times its side.
+    vector<int> corridor = blockSearch(L, blockOf(srcCell), blockOf(destCell), [&](int b) {
+        return L.sum[b] * side / max(1, L.count[b]);
+    }, nullptr);
+
+    vector<int> path;
+    long long cost = 0;
+    for (int m = max(0, margin); path.empty(); m = m * 2 + 1) {
+        vector<uint8_t> allowed(L.sum.size(), 0);
+        for (int b : corridor) {
+            int r = b / L.cols, c = b % L.cols;
+            for (int rr = max(0, r - m); rr <= min(L.rows - 1, r + m); ++rr)
+                for (int cc = max(0, c - m); cc <= min(L.cols - 1, c + m); ++cc) allowed[rr * L.cols + cc] = 1;
+        }
+        if (corridor.empty()) fill(allowed.begin(), allowed.end(), 1);
+        rep.corridorBlocks = count(allowed.begin(), allowed.end(), 1);
+        path = corridorSearch(sim, src, dest, level, L.cols, allowed, &cost, &rep.settled);
+        if (rep.corridorBlocks == (int)allowed.size()) break;   // whole grid searched
+    }
+    if (path.empty()) return path;
+
+    // Lower bounds: every step enters a node of weight >= the global minimum,
+    // and the route must enter each block on some chain of adjacent blocks.
+    const PyramidLevel& root = pyr.levels[top];
+    int globalMin = *min_element(root.minCost.begin(), root.minCost.end());
+    long long manhattan = abs(srcCell / sim.C - destCell / sim.C) + abs(srcCell % sim.C - destCell % sim.C);
+    long long coarse = 0;
+    blockSearch(L, blockOf(srcCell), blockOf(destCell), [&](int b) { return (long long)L.minCost[b]; }, &coarse);
+    rep.level = level;
+    rep.cost = cost;
+    rep.lowerBound = max(manhattan * globalMin, coarse);
+    rep.boundRatio = rep.lowerBound > 0 ? (double)cost / rep.lowerBound : 1.0;
+    if (report) *report = rep;
+    return path;
+}
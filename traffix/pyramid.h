@@ -0,0 +1,53 @@
+// pyramid.h
+// Multi-resolution congestion pyramid and hierarchical corridor routing.
+//
+// Level 0 holds the congestionWeight of every grid cell (the edge cost of
+// dijkstraCongestionPath); level k aggregates 2^k x 2^k blocks into the
+// sum, minimum and node count of their cells. updatePyramid refreshes the
+// pyramid after a cycle by recomputing only the blocks above changed cells.
+//
+// hierarchicalRoute plans a corridor of blocks on a coarse level (entering a
+// block costs its mean weight times the block side), widens it by `margin`
+// blocks, and runs the exact congestion search only inside it. The report
+// gives the route cost together with a certified lower bound on the optimum
+// (the larger of the Manhattan distance times the smallest weight and a
+// coarse search over block minima), so cost / lowerBound bounds the
+// suboptimality without solving the full problem.
+
+#pragma once
+
+#include "traffix.h"
+
+#include <cstdint>
+#include <vector>
+
+struct PyramidLevel {
+    int rows = 0, cols = 0;
+    std::vector<long long> sum;
+    std::vector<int> minCost;    // INT_MAX for blocks without intersections
+    std::vector<int> count;
+};
+
+struct CongestionPyramid {
+    int R = 0, C = 0;
+    std::vector<PyramidLevel> levels;   // levels[0] = cells
+    std::vector<int> dirty, nextDirty;
+    std::vector<uint8_t> queued;
+    long long blocksUpdated = 0;
+};
+
+struct HierRouteReport {
+    int level = 0;              // level the corridor was planned on
+    int corridorBlocks = 0;
+    int settled = 0;            // fine nodes taken off the heap
+    long long cost = 0;         // congestion cost of the route
+    long long lowerBound = 0;   // no route can cost less
+    double boundRatio = 1.0;    // cost / lowerBound, >= true suboptimality
+};
+
+void buildPyramid(CongestionPyramid& pyr, const Simulation& sim);
+// Returns the number of cells whose weight changed.
+int updatePyramid(CongestionPyramid& pyr, const Simulation& sim);
+// level < 0 picks the level at which the grid is about 32 blocks across.
+std::vector<int> hierarchicalRoute(const CongestionPyramid& pyr, const Simulation& sim, int src, int dest,
+                                   HierRouteReport* report = nullptr, int level = -1, int margin = 1);
@@ -0,0 +1,154 @@
+// render.cpp
+
+#include "render.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+
+// Green -> yellow -> red over 256 steps.
+static const uint8_t* colourTable() {
+    static uint8_t lut[256 * 3];
+    static bool ready = [] {
+        for (int k = 0; k < 256; ++k) {
+            lut[k * 3 + 0] = (uint8_t)min(255, k * 2);
+            lut[k * 3 + 1] = (uint8_t)min(255, (255 - k) * 2);
+            lut[k * 3 + 2] = 0;
+        }
+        return true;
+    }();
+    (void)ready;
+    return lut;
+}
+
+void renderHeatmap(Heatmap& img, const Simulation& sim, const HeatmapConfig& cfg, ThreadPool* pool) {
+    const int px = max(1, cfg.cellPx);
+    const int R = sim.R, C = sim.C;
+    img.width = C * px;
+    img.height = R * px;
+    img.rgb.resize((size_t)img.width * img.height * 3);
+    const uint8_t* lut = colourTable();
+    // queue total -> table index in 16.16 fixed point
+    const uint32_t scale = (uint32_t)((255u << 16) / (uint32_t)max(1, cfg.maxQueue));
+    const size_t stride = (size_t)img.width * 3;
+    const bool masked = !sim.grid.cellOf.empty();
+    static const uint8_t kNoNode[3] = {32, 32, 32};
+
+    auto rows = [&](int b, int e) {
+        for (int r = b; r < e; ++r) {
+            uint8_t* line = &img.rgb[(size_t)r * px * stride];
+            for (int c = 0; c < C; ++c) {
+                int id = masked ? cellNode(sim, r * C + c) : r * C + c;
+                const uint8_t* col = kNoNode;
+                if (id >= 0) {
+                    const Intersection& I = sim.city[id];
+                    uint32_t total = (uint32_t)max(0, I.q[0] + I.q[1] + I.q[2] + I.q[3]);
+                    col = lut + min<uint64_t>(255, ((uint64_t)total * scale) >> 16) * 3;
+                }
+                uint8_t* out = line + (size_t)c * px * 3;
+                for (int x = 0; x < px; ++x) memcpy(out + x * 3, col, 3);
+            }
+            for (int y = 1; y < px; ++y) memcpy(line + y * stride, line, stride);
+        }
+    };
+    if (pool) pool->parallelFor(R, max(1, 16 / px), rows);
+    else rows(0, R);
+}
+
+bool writePPM(const Heatmap& img, const string& path) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    fprintf(f, "P6\n%d %d\n255\n", img.width, img.height);
+    bool ok = fwrite(img.rgb.data(), 1, img.rgb.size(), f) == img.rgb.size();
+    return fclose(f) == 0 && ok;
+}
+
+static uint32_t crc32(const uint8_t* p, size_t n, uint32_t crc = 0) {
+    static uint32_t table[256];
+    static bool ready = [] {
+        for (uint32_t k = 0; k < 256; ++k) {
+            uint32_t c = k;
+            for (int j = 0; j < 8; ++j) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            table[k] = c;
+        }
+        return true;
+    }();
+    (void)ready;
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i) crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void put32(vector<uint8_t>& v, uint32_t x) {
+    uint8_t b[4] = {(uint8_t)(x >> 24), (uint8_t)(x >> 16), (uint8_t)(x >> 8), (uint8_t)x};
+    v.insert(v.end(), b, b + 4);
+}
+
+static void chunk(vector<uint8_t>& out, const char* type, const vector<uint8_t>& data) {
+    put32(out, (uint32_t)data.size());
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    put32(out, crc32(&out[start], out.size() - start));
+}
+
+bool writePNG(const Heatmap& img, const string& path) {
+    // Scanlines with filter type 0, wrapped in stored (uncompressed) deflate
+    // blocks of at most 65535 bytes.
+    const size_t rowBytes = (size_t)img.width * 3 + 1;
+    const size_t raw = rowBytes * img.height;
+    vector<uint8_t> z;
+    z.reserve(raw + raw / 65535 * 5 + 16);
+    z.push_back(0x78);
+    z.push_back(0x01);
+    uint32_t a = 1, b = 0;   // Adler-32
+    size_t pos = 0;
+    uint8_t block[65535];
+    while (pos < raw || raw == 0) {
+        uint16_t len = (uint16_t)min<size_t>(65535, raw - pos);
+        for (size_t k = 0; k < len; ++k) {
+            size_t at = pos + k, row = at / rowBytes, col = at % rowBytes;
+            block[k] = col == 0 ? 0 : img.rgb[row * (rowBytes - 1) + col - 1];
+        }
+        for (size_t k = 0; k < len; ++k) {
+            a = (a + block[k]) % 65521;
+            b = (b + a) % 65521;
+        }
+        pos += len;
+        z.push_back(pos >= raw ? 1 : 0);
+        z.push_back((uint8_t)len);
+        z.push_back((uint8_t)(len >> 8));
+        z.push_back((uint8_t)~len);
+        z.push_back((uint8_t)(~len >> 8));
+        z.insert(z.end(), block, block + len);
+        if (raw == 0) break;
+    }
+    put32(z, (b << 16) | a);
+
+    vector<uint8_t> out = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    vector<uint8_t> ihdr;
+    put32(ihdr, img.width);
+    put32(ihdr, img.height);
+    uint8_t rest[5] = {8, 2, 0, 0, 0};   // 8-bit RGB, deflate, no filter, no interlace
+    ihdr.insert(ihdr.end(), rest, rest + 5);
+    chunk(out, "IHDR", ihdr);
+    chunk(out, "IDAT", z);
+    chunk(out, "IEND", {});
+
+    ofstream f(path, ios::binary);
+    f.write((const char*)out.data(), out.size());
+    return (bool)f;
+}
+
+bool writeHeatmapFrame(Heatmap& img, const Simulation& sim, const HeatmapConfig& cfg,
+                       const string& prefix, ThreadPool* pool) {
+    renderHeatmap(img, sim, cfg, pool);
+    char num[16];
+    snprintf(num, sizeof num, "%06d", sim.cycle);
+    string path = prefix + num + (cfg.png ? ".png" : ".ppm");
+    return cfg.png ? writePNG(img, path) : writePPM(img, path);
+}
@@ -0,0 +1,34 @@
+// render.h
+// Congestion heatmaps: every node becomes a cellPx x cellPx block coloured
+// by its total queue (green = empty, yellow, red = maxQueue or more; cells
+// of a masked grid without an intersection are dark grey).
+// Rows are rendered in parallel on the given pool through a 256-entry
+// colour table, so a 2000 x 2000 grid takes a few milliseconds per frame.
+// Frames are written as binary PPM or as PNG (stored deflate blocks, no
+// zlib needed); writeHeatmapFrame numbers the files by cycle.
+
+#pragma once
+
+#include "traffix.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct HeatmapConfig {
+    int cellPx = 1;
+    int maxQueue = 40;      // total queue mapped to full red
+    bool png = false;       // frame format for writeHeatmapFrame
+};
+
+struct Heatmap {
+    int width = 0, height = 0;
+    std::vector<uint8_t> rgb;   // width * height * 3, row major
+};
+
+void renderHeatmap(Heatmap& img, const Simulation& sim, const HeatmapConfig& cfg, ThreadPool* pool = nullptr);
+bool writePPM(const Heatmap& img, const std::string& path);
+bool writePNG(const Heatmap& img, const std::string& path);
+// Render and write <prefix><cycle, 6 digits>.ppm (or .png).
+bool writeHeatmapFrame(Heatmap& img, const Simulation& sim, const HeatmapConfig& cfg,
+                       const std::string& prefix, ThreadPool* pool = nullptr);
@@ -0,0 +1,182 @@
+// scenario.cpp
+
+#include "scenario.h"
+#include "eta.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+static const char* const kClassNames[PRIO_CLASSES] = {"fire", "ambulance", "police", "transit", "freight"};
+
+static bool parseDirs(const string& s, uint8_t& mask) {
+    mask = 0;
+    for (char ch : s) {
+        size_t d = string("NSEW").find((char)toupper((unsigned char)ch));
+        if (d == string::npos) return false;
+        mask |= (uint8_t)(1u << d);
+    }
+    return mask != 0;
+}
+
+bool loadScenario(Scenario& sc, istream& in, string* error) {
+    vector<ScenarioEvent> events;
+    string line;
+    int lineNo = 0;
+    auto fail = [&](const string& why) {
+        if (error) *error = "line " + to_string(lineNo) + ": " + why;
+        return false;
+    };
+    while (getline(in, line)) {
+        ++lineNo;
+        line = line.substr(0, line.find('#'));
+        istringstream ls(line);
+        string at, kind;
+        if (!(ls >> at)) continue;
+        ScenarioEvent ev = {};
+        if (at != "at" || !(ls >> ev.cycle >> kind) || ev.cycle < 1) return fail("expected 'at CYCLE EVENT'");
+
+        if (kind == "dispatch") {
+            ev.kind = EV_DISPATCH;
+            ev.mask = PRIO_AMBULANCE;
+            if (!(ls >> ev.r0 >> ev.c0)) return fail("dispatch needs SRC DEST");
+            string word;
+            while (ls >> word) {
+                if (word == "shortest") ev.mode = 0;
+                else if (word == "congestion") ev.mode = 1;
+                else if (word == "fastest") ev.mode = 2;
+                else {
+                    int k = find(kClassNames, kClassNames + PRIO_CLASSES, word) - kClassNames;
+                    if (k == PRIO_CLASSES) return fail("unknown dispatch option '" + word + "'");
+                    ev.mask = (uint8_t)k;
+                }
+            }
+            events.push_back(ev);
+            continue;
+        }
+
+        if (!(ls >> ev.r0 >> ev.c0 >> ev.r1 >> ev.c1)) return fail(kind + " needs a region R0 C0 R1 C1");
+        if (ev.r0 > ev.r1 || ev.c0 > ev.c1) return fail("empty region");
+        if (kind == "close" || kind == "open") {
+            ev.kind = kind == "close" ? EV_CLOSE : EV_OPEN;
+            string dirs;
+            ev.mask = 0xF;
+            if (ls >> dirs && !parseDirs(dirs, ev.mask)) return fail("directions must be letters from NSEW");
+            events.push_back(ev);
+        } else if (kind == "surge") {
+            ev.kind = EV_SURGE;
+            ev.duration = 1;
+            string word;
+            if (!(ls >> ev.value) || ev.value < 0) return fail("surge needs VEH >= 0");
+            if (ls >> word && (word != "for" || !(ls >> ev.duration) || ev.duration < 1)) return fail("expected 'for N'");
+            events.push_back(ev);
+        } else if (kind == "timing") {
+            ev.kind = EV_TIMING;
+            if (!(ls >> ev.value >> ev.rate) || ev.value < 1 || ev.rate < 0) return fail("timing needs CYCLESEC >= 1 SATFLOW >= 0");
+            events.push_back(ev);
+        } else {
+            return fail("unknown event '" + kind + "'");
+        }
+    }
+    stable_sort(events.begin(), events.end(),
+                [](const ScenarioEvent& a, const ScenarioEvent& b) { return a.cycle < b.cycle; });
+    sc.events.swap(events);
+    sc.active.clear();
+    sc.cursor = 0;
+    sc.applied = 0;
+    return true;
+}
+
+bool loadScenarioFile(Scenario& sc, const string& path, string* error) {
+    ifstream f(path);
+    if (!f) {
+        if (error) *error = "cannot open " + path;
+        return false;
+    }
+    return loadScenario(sc, f, error);
+}
+
+static void applyEvent(const ScenarioEvent& ev, Simulation& sim, ostream* log) {
+    if (ev.kind == EV_DISPATCH) {
+        int n = nodeCount(sim);
+        if (ev.r0 < 0 || ev.r0 >= n || ev.c0 < 0 || ev.c0 >= n) return;
+        vector<int> path = ev.mode == 2 ? fastestRoute(sim, ev.r0, ev.c0) : route(sim, ev.r0, ev.c0, ev.mode == 1);
+        requestPriority(sim, (PriorityClass)ev.mask, path);
+        if (log) printPath(*log, path, string("Scenario dispatch (") + kClassNames[ev.mask] + "):", sim);
+        return;
+    }
+    int r0 = max(0, ev.r0), c0 = max(0, ev.c0);
+    int r1 = min(sim.R - 1, ev.r1), c1 = min(sim.C - 1, ev.c1);
+    for (int r = r0; r <= r1; ++r) {
+        for (int c = c0; c <= c1; ++c) {
+            int i = cellNode(sim, nodeId(r, c, sim.C));
+            if (i < 0) continue;
+            switch (ev.kind) {
+            case EV_CLOSE: {
+                uint8_t& en = sim.params.enabled[i];
+                en &= (uint8_t)~ev.mask;
+                // Vehicles waiting on a closed approach divert to the first open
+                // one, as vehicles arriving over a meso link do. With every
+                // approach closed they wait until one reopens.
+                if (!en) break;
+                int to = en & 1u ? 0 : en & 2u ? 1 : en & 4u ? 2 : 3;
+                for (int d = 0; d < 4; ++d)
+                    if ((ev.mask >> d) & 1u && d != to) {
+                        sim.city[i].q[to] += sim.city[i].q[d];
+                        sim.city[i].q[d] = 0;
+                    }
+                break;
+            }
+            case EV_OPEN: sim.params.enabled[i] |= ev.mask; break;
+            case EV_SURGE:
+                for (int d = 0; d < 4; ++d) {
+                    int add = ev.value * ((sim.params.enabled[i] >> d) & 1);
+                    sim.city[i].q[d] += add;
+                    sim.vehiclesArrivedTotal += add;
+                }
+                break;
+            case EV_TIMING:
+                sim.params.cycleSec[i] = ev.value;
+                for (int d = 0; d < 4; ++d) {
+                    int a = i * 4 + d;
+                    sim.params.satFlow[a] = ev.rate;
+                    if (!sim.params.rateQ16.empty())
+                        sim.params.rateQ16[a] = (uint32_t)max(0.0, (double)ev.rate * sim.params.lanes[a] * 65536.0 + 0.5);
+                }
+                break;
+            default: break;
+            }
+        }
+    }
+    if (log && ev.kind != EV_SURGE)
+        *log << "Scenario " << (ev.kind == EV_CLOSE ? "close" : ev.kind == EV_OPEN ? "open" : "timing")
+             << " rows " << r0 << "-" << r1 << " cols " << c0 << "-" << c1 << "\n";
+}
+
+void applyScenario(Scenario& sc, Simulation& sim, ostream* log) {
+    int next = sim.cycle + 1;
+    // Surges that started earlier, dropped once their last cycle has passed.
+    size_t keep = 0;
+    for (const ScenarioEvent& ev : sc.active) {
+        if (ev.cycle + ev.duration <= next) continue;
+        applyEvent(ev, sim, log);
+        sc.active[keep++] = ev;
+    }
+    sc.active.resize(keep);
+    while (sc.cursor < sc.events.size() && sc.events[sc.cursor].cycle <= next) {
+        const ScenarioEvent& ev = sc.events[sc.cursor++];
+        applyEvent(ev, sim, log);
+        if (ev.kind == EV_SURGE && ev.duration > 1) sc.active.push_back(ev);
+        ++sc.applied;
+    }
+}
+
+void runScenario(Scenario& sc, Simulation& sim, int n, ostream* log) {
+    for (int k = 0; k < n; ++k) {
+        applyScenario(sc, sim, log);
+        step(sim);
+    }
+}
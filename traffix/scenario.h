@@ -0,0 +1,65 @@
+// scenario.h
+// Scripted scenarios: a text file of timed events, compiled once into an
+// array sorted by cycle (file order within a cycle) and consumed through a
+// cursor, so running a scripted day costs one comparison per cycle plus the
+// events that actually fire.
+//
+// One event per line, '#' starts a comment. CYCLE is 1-based like the CLI
+// prompt: the event applies just before that cycle is simulated. Regions
+// are inclusive row/column ranges R0 C0 R1 C1.
+//
+//   at CYCLE dispatch SRC DEST [shortest|congestion|fastest] [fire|ambulance|police|transit|freight]
+//   at CYCLE close R0 C0 R1 C1 [NSEW]     close approaches (default all four);
+//                                         their queues join the first open
+//                                         approach, or wait for a reopening
+//                                         if the whole node is closed
+//   at CYCLE open R0 C0 R1 C1 [NSEW]      reopen them
+//   at CYCLE surge R0 C0 R1 C1 VEH [for N]
+//                                         VEH extra vehicles per open approach,
+//                                         every cycle for N cycles (default 1)
+//   at CYCLE timing R0 C0 R1 C1 CYCLESEC SATFLOW
+//                                         per-node cycle length and saturation flow
+
+#pragma once
+
+#include "traffix.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+enum ScenarioEventKind : uint8_t {
+    EV_DISPATCH,
+    EV_CLOSE,
+    EV_OPEN,
+    EV_SURGE,
+    EV_TIMING
+};
+
+struct ScenarioEvent {
+    int cycle;
+    ScenarioEventKind kind;
+    uint8_t mask;          // close/open: approach bits; dispatch: priority class
+    uint8_t mode;          // dispatch: 0 shortest, 1 least congested, 2 fastest
+    int r0, c0, r1, c1;    // region; dispatch uses r0 = src, c0 = dest
+    int value;             // surge vehicles, timing cycle seconds
+    float rate;            // timing saturation flow
+    int duration;          // surge: cycles it stays in force
+};
+
+struct Scenario {
+    std::vector<ScenarioEvent> events;   // sorted by cycle
+    std::vector<ScenarioEvent> active;   // surges still in force
+    size_t cursor = 0;
+    long long applied = 0;
+};
+
+// Parse and compile a script. On failure returns false and, if error is
+// given, a message naming the offending line.
+bool loadScenario(Scenario& sc, std::istream& in, std::string* error = nullptr);
+bool loadScenarioFile(Scenario& sc, const std::string& path, std::string* error = nullptr);
+// Apply every event due before the simulation's next cycle.
+void applyScenario(Scenario& sc, Simulation& sim, std::ostream* log = nullptr);
+// applyScenario + step, n times.
+void runScenario(Scenario& sc, Simulation& sim, int n, std::ostream* log = nullptr);
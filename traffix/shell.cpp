@@ -0,0 +1,141 @@
+// shell.cpp
+
+#include "shell.h"
+#include "eta.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+static const char* const kClassNames[PRIO_CLASSES] = {"fire", "ambulance", "police", "transit", "freight"};
+
+static void printHelp(ostream& out) {
+    out << "Commands:\n"
+        << "  step [N]                          run N cycles (default 1)\n"
+        << "  dispatch SRC DEST [shortest|congestion|fastest] [fire|ambulance|police|transit|freight]\n"
+        << "  route SRC DEST                    shortest and least congested paths\n"
+        << "  show [R0 C0 R1 C1]                network state of a region\n"
+        << "  stats                             totals so far\n"
+        << "  save FILE                         write a snapshot of the state\n"
+        << "  help, quit\n";
+}
+
+static void printStats(const Simulation& sim, ostream& out) {
+    out << "Cycle: " << sim.cycle << "\n";
+    out << "Vehicles arrived so far: " << sim.vehiclesArrivedTotal << "\n";
+    out << "Total vehicles served so far: " << sim.totalVehiclesServed << "\n";
+    if (sim.vehiclesBlocked) out << "Arrivals blocked by storage: " << sim.vehiclesBlocked << "\n";
+    if (sim.meso.cyclesPerWeight > 0) out << "Vehicles on links: " << sim.meso.inTransit << "\n";
+    out << "Average queue length per node per cycle: " << fixed << setprecision(2)
+        << averageQueueLength(sim) << "\n";
+    out.unsetf(ios::floatfield);
+}
+
+static bool validNode(const Simulation& sim, int u) { return u >= 0 && u < nodeCount(sim); }
+
+bool shellCommand(Simulation& sim, const string& line, ostream& out) {
+    istringstream in(line);
+    string cmd;
+    if (!(in >> cmd)) return true;
+
+    if (cmd == "quit" || cmd == "exit") return false;
+    if (cmd == "help") {
+        printHelp(out);
+    } else if (cmd == "step") {
+        int n = 1;
+        string arg;
+        if (in >> arg) {
+            istringstream num(arg);
+            if (!(num >> n) || n < 0) { out << "usage: step [N]\n"; return true; }
+        }
+        step(sim, n);
+        out << "Cycle " << sim.cycle << ": arrived " << sim.vehiclesArrivedTotal
+            << ", served " << sim.totalVehiclesServed << "\n";
+    } else if (cmd == "dispatch") {
+        int src, dest;
+        if (!(in >> src >> dest) || !validNode(sim, src) || !validNode(sim, dest)) {
+            out << "usage: dispatch SRC DEST [shortest|congestion|fastest] [class] (nodes 0 to " << nodeCount(sim) - 1 << ")\n";
+            return true;
+        }
+        bool congestion = false, fastest = false;
+        int cls = PRIO_AMBULANCE;
+        string word;
+        while (in >> word) {
+            if (word == "congestion") congestion = true, fastest = false;
+            else if (word == "shortest") congestion = fastest = false;
+            else if (word == "fastest") fastest = true, congestion = false;
+            else {
+                int k = find(kClassNames, kClassNames + PRIO_CLASSES, word) - kClassNames;
+                if (k == PRIO_CLASSES) { out << "unknown option: " << word << "\n"; return true; }
+                cls = k;
+            }
+        }
+        vector<int> path;
+        if (fastest) {
+            path = fastestRoute(sim, src, dest);
+            if (cls == PRIO_AMBULANCE) sim.ambulancePath = path;
+            else requestPriority(sim, (PriorityClass)cls, path);
+        } else {
+            path = cls == PRIO_AMBULANCE ? dispatchAmbulance(sim, src, dest, congestion)
+                                         : dispatchPriority(sim, (PriorityClass)cls, src, dest, congestion);
+        }
+        const char* label = fastest ? "FASTEST PATH" : congestion ? "LEAST CONGESTED PATH" : "SHORTEST PATH";
+        printPath(out, path, string(label) + " (" + kClassNames[cls] + "):", sim);
+        if (!path.empty()) out << "ETA: " << estimateEta(sim, path) << " s\n";
+        if (!path.empty()) out << "Priority applies on the next step.\n";
+    } else if (cmd == "route") {
+        int src, dest;
+        if (!(in >> src >> dest) || !validNode(sim, src) || !validNode(sim, dest)) {
+            out << "usage: route SRC DEST (nodes 0 to " << nodeCount(sim) - 1 << ")\n";
+            return true;
+        }
+        printPath(out, route(sim, src, dest), "SHORTEST PATH:", sim);
+        printPath(out, route(sim, src, dest, true), "LEAST CONGESTED PATH:", sim);
+    } else if (cmd == "show") {
+        int r0 = 0, c0 = 0, r1 = sim.R - 1, c1 = sim.C - 1;
+        if (in >> r0) {
+            if (!(in >> c0 >> r1 >> c1)) { out << "usage: show [R0 C0 R1 C1]\n"; return true; }
+        }
+        r0 = max(0, r0); c0 = max(0, c0);
+        r1 = min(sim.R - 1, r1); c1 = min(sim.C - 1, c1);
+        if (r0 > r1 || c0 > c1) { out << "empty region\n"; return true; }
+        printNetworkRegion(out, sim, r0, c0, r1, c1);
+    } else if (cmd == "stats") {
+        printStats(sim, out);
+    } else if (cmd == "save") {
+        string path;
+        if (!(in >> path)) { out << "usage: save FILE\n"; return true; }
+        out << (saveSnapshot(sim, path) ? "Saved to " : "Could not write ") << path << "\n";
+    } else {
+        out << "Unknown command: " << cmd << " (try help)\n";
+    }
+    return true;
+}
+
+void runShell(Simulation& sim, istream& in, ostream& out, bool prompt) {
+    string line;
+    while (true) {
+        if (prompt) out << "traffix> " << flush;
+        if (!getline(in, line)) break;
+        if (!shellCommand(sim, line, out)) break;
+    }
+}
+
+bool saveSnapshot(const Simulation& sim, const string& path) {
+    ofstream f(path);
+    if (!f) return false;
+    f << "traffix-snapshot 1\n";
+    f << "grid " << sim.R << " " << sim.C << "\n";
+    f << "cycle " << sim.cycle << "\n";
+    f << "timing " << sim.totalCycleSec << " " << sim.serviceRate << "\n";
+    f << "totals " << sim.vehiclesArrivedTotal << " " << sim.totalVehiclesServed << " "
+      << sim.cumulativeQueueSum << " " << sim.vehiclesBlocked << "\n";
+    // node id, queues N S E W, green direction
+    for (const auto& I : sim.city)
+        f << I.id << " " << I.q[0] << " " << I.q[1] << " " << I.q[2] << " " << I.q[3] << " " << I.green_dir << "\n";
+    return (bool)f;
+}
@@ -0,0 +1,26 @@
+// shell.h
+// Interactive command session over a resident Simulation. The grid, graph
+// and queues stay in memory between commands, so dispatching another
+// vehicle or running more cycles continues from the current state.
+//
+//   step [N]                          run N cycles (default 1)
+//   dispatch SRC DEST [shortest|congestion|fastest] [fire|ambulance|police|transit|freight]
+//   route SRC DEST                    shortest and least congested paths
+//   show [R0 C0 R1 C1]                network state of a region (default: all)
+//   stats                             totals so far
+//   save FILE                         write a snapshot of the state
+//   help, quit
+
+#pragma once
+
+#include "traffix.h"
+
+#include <iosfwd>
+#include <string>
+
+// Run one command line. Returns false when the session should end.
+bool shellCommand(Simulation& sim, const std::string& line, std::ostream& out);
+// Read commands until quit or end of input; prompt with "traffix> " if asked.
+void runShell(Simulation& sim, std::istream& in, std::ostream& out, bool prompt = true);
+// Text snapshot: grid size, cycle, totals and the per-node queues.
+bool saveSnapshot(const Simulation& sim, const std::string& path);
@@ -0,0 +1,128 @@
+// sparse.cpp
+
+#include "sparse.h"
+
+#include <algorithm>
+
+using namespace std;
+
+static inline bool testBit(const vector<uint64_t>& b, int i) { return (b[i >> 6] >> (i & 63)) & 1u; }
+static inline void putBit(vector<uint64_t>& b, int i, bool on) {
+    if (on) b[i >> 6] |= 1ull << (i & 63);
+    else b[i >> 6] &= ~(1ull << (i & 63));
+}
+
+void initGridMask(GridMask& m, int R, int C, bool allOn) {
+    m.R = max(1, R);
+    m.C = max(1, C);
+    size_t words = ((size_t)m.R * m.C + 63) / 64;
+    m.cells.assign(words, 0);
+    m.east.assign(words, 0);
+    m.south.assign(words, 0);
+    if (!allOn) return;
+    for (int r = 0; r < m.R; ++r)
+        for (int c = 0; c < m.C; ++c) {
+            int cell = r * m.C + c;
+            putBit(m.cells, cell, true);
+            putBit(m.east, cell, c + 1 < m.C);
+            putBit(m.south, cell, r + 1 < m.R);
+        }
+}
+
+bool maskHasCell(const GridMask& m, int r, int c) {
+    return r >= 0 && r < m.R && c >= 0 && c < m.C && testBit(m.cells, r * m.C + c);
+}
+
+// Segment (cell, bit array) owning the road from (r, c) in direction d.
+static bool roadSlot(const GridMask& m, int r, int c, int d, int& cell, bool& isEast) {
+    int nr = r + dr[d], nc = c + dc[d];
+    if (!maskHasCell(m, r, c) || !maskHasCell(m, nr, nc)) return false;
+    isEast = d >= 2;
+    cell = min(r, nr) * m.C + min(c, nc);
+    return true;
+}
+
+bool maskHasRoad(const GridMask& m, int r, int c, int d) {
+    int cell;
+    bool isEast;
+    if (!roadSlot(m, r, c, d, cell, isEast)) return false;
+    return testBit(isEast ? m.east : m.south, cell);
+}
+
+void setMaskRoad(GridMask& m, int r, int c, int d, bool on) {
+    int cell;
+    bool isEast;
+    if (!roadSlot(m, r, c, d, cell, isEast)) return;
+    putBit(isEast ? m.east : m.south, cell, on);
+}
+
+void setMaskCell(GridMask& m, int r, int c, bool on) {
+    if (r < 0 || r >= m.R || c < 0 || c >= m.C) return;
+    if (!on)
+        for (int d = 0; d < 4; ++d) setMaskRoad(m, r, c, d, false);
+    putBit(m.cells, r * m.C + c, on);
+}
+
+int maskCellCount(const GridMask& m) {
+    int n = 0;
+    for (uint64_t w : m.cells) n += __builtin_popcountll(w);
+    return n;
+}
+
+void gridMaskFromAscii(GridMask& m, const vector<string>& rows) {
+    int R = rows.size(), C = 0;
+    for (const auto& row : rows) C = max(C, (int)row.size());
+    initGridMask(m, R, C, false);
+    auto on = [&](int r, int c) { return c < (int)rows[r].size() && rows[r][c] != ' ' && rows[r][c] != '.'; };
+    for (int r = 0; r < R; ++r)
+        for (int c = 0; c < C; ++c)
+            if (on(r, c)) putBit(m.cells, r * m.C + c, true);
+    for (int r = 0; r < R; ++r)
+        for (int c = 0; c < C; ++c) {
+            if (!on(r, c)) continue;
+            if (c + 1 < C && on(r, c + 1)) putBit(m.east, r * m.C + c, true);
+            if (r + 1 < R && on(r + 1, c)) putBit(m.south, r * m.C + c, true);
+        }
+}
+
+void initMaskedSimulation(Simulation& sim, const GridMask& mask, const SimConfig& cfg) {
+    sim = Simulation();
+    sim.R = mask.R;
+    sim.C = mask.C;
+    sim.totalCycleSec = cfg.totalCycleSec;
+    sim.serviceRate = cfg.serviceRate;
+    sim.initialQueueMax = max(1, cfg.initialQueueMax);
+
+    // Rank directory and select table.
+    GridIndex& g = sim.grid;
+    g.bits = mask.cells;
+    g.rank.resize(g.bits.size());
+    uint32_t seen = 0;
+    for (size_t k = 0; k < g.bits.size(); ++k) {
+        g.rank[k] = seen;
+        seen += __builtin_popcountll(g.bits[k]);
+    }
+    g.cellOf.reserve(seen);
+    for (size_t k = 0; k < g.bits.size(); ++k)
+        for (uint64_t w = g.bits[k]; w; w &= w - 1) g.cellOf.push_back((int)(k * 64 + __builtin_ctzll(w)));
+
+    int n = seen;
+    sim.city.assign(n, Intersection());
+    sim.graph.assign(n, {});
+    vector<uint8_t> enabled(n, 0);
+    for (int u = 0; u < n; ++u) {
+        sim.city[u].id = u;
+        int cell = g.cellOf[u], r = cell / sim.C, c = cell % sim.C;
+        for (int d = 0; d < 4; ++d) {
+            int nr = r + dr[d], nc = c + dc[d];
+            bool outside = nr < 0 || nr >= sim.R || nc < 0 || nc >= sim.C;
+            if (outside) { enabled[u] |= 1u << d; continue; }
+            if (!maskHasRoad(mask, r, c, d)) continue;
+            enabled[u] |= 1u << d;
+            sim.graph[u].push_back({cellNode(sim, nr * sim.C + nc), 1});
+        }
+    }
+    sim.params.enabled = enabled;
+    setUniformTiming(sim, sim.totalCycleSec, sim.serviceRate);
+    resetSimulation(sim, cfg.seed);
+}
@@ -0,0 +1,41 @@
+// sparse.h
+// Masked sparse grids for real city shapes. A GridMask marks which cells of
+// the R x C bounding grid hold intersections and which road segments exist
+// (bit per cell for the road to its east and to its south neighbour).
+// initMaskedSimulation keeps only the marked cells: node ids are compacted
+// in row-major order, so per-node state and the graph scale with the real
+// network, and the Simulation's GridIndex maps between node ids and cells
+// by select (cellOf) and rank (cellNode). An approach exists where a road
+// segment does, and on the edge of the bounding grid (external inflow, as
+// on a full grid). A fully set mask reproduces initSimulation exactly.
+
+#pragma once
+
+#include "traffix.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct GridMask {
+    int R = 0, C = 0;
+    std::vector<uint64_t> cells;   // bit r * C + c = intersection exists
+    std::vector<uint64_t> east;    // road between cell and cell + 1
+    std::vector<uint64_t> south;   // road between cell and cell + C
+};
+
+// allOn = every cell and every road segment present; otherwise empty.
+void initGridMask(GridMask& m, int R, int C, bool allOn = true);
+// Removing a cell also removes its road segments.
+void setMaskCell(GridMask& m, int r, int c, bool on);
+// Road from (r, c) in direction d (0=N,1=S,2=E,3=W); only added between two
+// existing cells.
+void setMaskRoad(GridMask& m, int r, int c, int d, bool on);
+bool maskHasCell(const GridMask& m, int r, int c);
+bool maskHasRoad(const GridMask& m, int r, int c, int d);
+int maskCellCount(const GridMask& m);
+// ASCII map, one string per row: any character other than ' ' or '.' is an
+// intersection; roads join horizontally and vertically adjacent ones.
+void gridMaskFromAscii(GridMask& m, const std::vector<std::string>& rows);
+
+void initMaskedSimulation(Simulation& sim, const GridMask& mask, const SimConfig& cfg);
@@ -0,0 +1,724 @@
+// traffix.cpp
+// Core simulation: routing, signal allocation and the per-cycle engine.
+
+#include "traffix.h"
+#include "parallel.h"
+#include "alt.h"
+
+#include <atomic>
+#include <iostream>
+#include <queue>
+#include <algorithm>
+#include <cmath>
+#include <climits>
+#include <cstring>
+
+using namespace std;
+
+const int dr[4] = {-1, 1, 0, 0}; // N S E W
+const int dc[4] = {0, 0, 1, -1};
+string dirName(int d) {
+    if (d == 0) return "N";
+    if (d == 1) return "S";
+    if (d == 2) return "E";
+    return "W";
+}
+
+// Dijkstra to find shortest path on grid graph
+vector<int> dijkstraPath(int src, int dest, const vector<vector<Edge>>& graph) {
+    int n = graph.size();
+    const int INF = 1e9;
+    vector<int> dist(n, INF), parent(n, -1);
+    dist[src] = 0;
+    priority_queue<pair<int,int>, vector<pair<int,int>>, greater<pair<int,int>>> pq;
+    pq.push({0, src});
+    while (!pq.empty()) {
+        auto [d,u] = pq.top(); pq.pop();
+        if (d != dist[u]) continue;
+        if (u == dest) break;
+        for (auto &e : graph[u]) {
+            int v = e.to;
+            if (dist[u] + e.w < dist[v]) {
+                dist[v] = dist[u] + e.w;
+                parent[v] = u;
+                pq.push({dist[v], v});
+            }
+        }
+    }
+    vector<int> path;
+    if (dist[dest] == INF) return path;
+    for (int v = dest; v != -1; v = parent[v]) path.push_back(v);
+    reverse(path.begin(), path.end());
+    return path;
+}
+
+// Find least congested path: uses total queue sum as edge weight
+vector<int> dijkstraCongestionPath(int src, int dest, const vector<vector<Edge>>& graph, const vector<Intersection>& city) {
+    int n = graph.size();
+    const int INF = 1e9;
+    vector<int> dist(n, INF), parent(n, -1);
+    dist[src] = 0;
+    priority_queue<pair<int,int>, vector<pair<int,int>>, greater<pair<int,int>>> pq;
+    pq.push({0, src});
+    while (!pq.empty()) {
+        auto [d,u] = pq.top(); pq.pop();
+        if (d != dist[u]) continue;
+        if (u == dest) break;
+        for (auto &e : graph[u]) {
+            int v = e.to;
+            // Weight = 1 (base distance) + congestion (total queue at v, scaled)
+            int edgeWeight = congestionWeight(city[v]);
+            if (dist[u] + edgeWeight < dist[v]) {
+                dist[v] = dist[u] + edgeWeight;
+                parent[v] = u;
+                pq.push({dist[v], v});
+            }
+        }
+    }
+    vector<int> path;
+    if (dist[dest] == INF) return path;
+    for (int v = dest; v != -1; v = parent[v]) path.push_back(v);
+    reverse(path.begin(), path.end());
+    return path;
+}
+
+// Build grid graph: R rows x C cols, edges between 4-neighbors with weight = 1
+void buildGridGraph(int R, int C, vector<vector<Edge>>& graph) {
+    int n = R * C;
+    graph.assign(n, {});
+    for (int r = 0; r < R; ++r) {
+        for (int c = 0; c < C; ++c) {
+            int u = nodeId(r,c,C);
+            for (int d = 0; d < 4; ++d) {
+                int nr = r + dr[d], nc = c + dc[d];
+                if (nr >= 0 && nr < R && nc >= 0 && nc < C) {
+                    int v = nodeId(nr,nc,C);
+                    graph[u].push_back({v, 1});
+                }
+            }
+        }
+    }
+}
+
+// Print a simple visualization of the intersections and their queues
+void printNetworkState(ostream& out, const Simulation& sim, int cycle) {
+    out << "\n=== Cycle " << cycle << " Network State ===\n";
+    int n = nodeCount(sim);
+    for (int id = 0; id < n; ++id) {
+        const Intersection &I = sim.city[id];
+        out << "[Node " << id << "]";
+        out << " (N:" << I.q[0] << " S:" << I.q[1] << " E:" << I.q[2] << " W:" << I.q[3] << ")";
+        if (I.green_dir >= 0) out << " G:" << dirName(I.green_dir);
+        out << "  ";
+        // ids are row-major, so a row ends where the next node's row differs
+        if (id + 1 == n || nodeCell(sim, id + 1) / sim.C != nodeCell(sim, id) / sim.C) out << "\n";
+    }
+    out << "==============================\n";
+}
+
+void splitGreenTimes(const int* demand, int n, int T, int* times) {
+    // The active mask is applied arithmetically so partial junctions cost
+    // the same as full ones.
+    int active = 0;
+    long long total = 0;
+    for (int k = 0; k < n; ++k) {
+        int on = demand[k] >= 0;
+        active += on;
+        total += (long long)demand[k] * on;
+    }
+    if (total == 0) {
+        for (int k = 0; k < n; ++k) times[k] = 0;
+        if (active == 0) return;
+        int first = 0;
+        while (demand[first] < 0) ++first;
+        for (int k = 0; k < n; ++k) times[k] = (T / active) * (demand[k] >= 0);
+        times[first] += T % active;
+        return;
+    }
+    int assigned = 0;
+    for (int k = 0; k < n; ++k) {
+        int t = (int)((2LL * demand[k] * T + total) / (2 * total));
+        times[k] = max(1, t) * (demand[k] >= 0);
+        assigned += times[k];
+    }
+    while (assigned > T) {
+        int idx = -1, bestQ = INT_MAX;
+        for (int k = 0; k < n; ++k) if (times[k] > 1 && demand[k] < bestQ) { idx = k; bestQ = demand[k]; }
+        if (idx == -1) break;
+        times[idx]--; assigned--;
+    }
+    while (assigned < T) {
+        int idx = -1, bestQ = -1;
+        for (int k = 0; k < n; ++k) if (demand[k] > bestQ) { idx = k; bestQ = demand[k]; }
+        times[idx]++; assigned++;
+    }
+}
+
+// Decide green time proportionally for each direction at a node.
+// Only approaches whose bit is set in `enabled` receive green.
+void allocateGreenTimes(const Intersection &I, int totalCycleSec, int times[4], unsigned enabled) {
+    int demand[4];
+    for (int i = 0; i < 4; ++i) demand[i] = (enabled >> i) & 1u ? I.q[i] : -1;
+    splitGreenTimes(demand, 4, totalCycleSec, times);
+}
+
+vector<int> allocateGreenTimes(const Intersection &I, int totalCycleSec) {
+    vector<int> times(4, 0);
+    allocateGreenTimes(I, totalCycleSec, times.data());
+    return times;
+}
+
+void greenTimesFromSplits(const float splits[4], int totalCycleSec, int times[4], unsigned enabled) {
+    float s[4], total = 0;
+    for (int i = 0; i < 4; ++i) {
+        s[i] = ((enabled >> i) & 1u) && splits[i] > 0 ? splits[i] : 0.0f;
+        total += s[i];
+    }
+    if (!(total > 0)) {
+        Intersection empty;
+        allocateGreenTimes(empty, totalCycleSec, times, enabled);
+        return;
+    }
+    int assigned = 0;
+    float rem[4];
+    for (int i = 0; i < 4; ++i) {
+        float exact = s[i] / total * totalCycleSec;
+        times[i] = (int)exact;
+        rem[i] = exact - times[i];
+        assigned += times[i];
+    }
+    while (assigned < totalCycleSec) {
+        int idx = 0;
+        for (int i = 1; i < 4; ++i) if (rem[i] > rem[idx]) idx = i;
+        times[idx]++; rem[idx] = -1.0f; assigned++;
+    }
+}
+
+// Parameter sources for the cycle kernels. The engine is instantiated once
+// per source so the uniform scalars and the per-node arrays each compile to
+// straight loads, and a fully heterogeneous city costs the same per node as
+// a uniform one.
+struct UniformInputs {
+    int cycle; float rate;
+    int cycleSec(int) const { return cycle; }
+    unsigned enabled(int) const { return 0xF; }
+    float serviceRate(int, int) const { return rate; }
+};
+struct NodeInputs {
+    const NodeParams &p;
+    int cycleSec(int i) const { return p.cycleSec[i]; }
+    unsigned enabled(int i) const { return p.enabled[i]; }
+    float serviceRate(int i, int d) const { return p.satFlow[i * 4 + d] * p.lanes[i * 4 + d]; }
+};
+
+// Fixed-point service: capacity accrues as Q16.16 credit; whole vehicles are
+// discharged and the fraction carries into the next green. Integer only, so
+// it is bit-exact on every compiler and platform.
+static inline void accrueCredit(const uint32_t rateQ16[4], const int green[4], uint32_t credit[4]) {
+    for (int d = 0; d < 4; ++d) credit[d] = accrueCredit(credit[d], rateQ16[d], (uint32_t)green[d]);
+}
+
+static inline void settleCredit(const int served[4], uint32_t credit[4]) {
+    for (int d = 0; d < 4; ++d) credit[d] = settleCredit(credit[d], served[d]);
+}
+
+// Serve kernel: vehicles each approach can discharge in its green time.
+template <typename Inputs>
+static inline void serviceDemand(const Inputs& in, int i, const int q[4], const int green[4], int demand[4]) {
+    for (int d = 0; d < 4; ++d) {
+        // float rates: epsilon absorbs representation error (0.7f * 10 < 7);
+        // capacity is non-negative so truncation is floor
+        int canServe = (int)(in.serviceRate(i, d) * green[d] + 1e-4f);
+        demand[d] = min(canServe, q[d]);
+    }
+}
+
+int applyPriority(const Intersection &I, const PriorityPolicy &policy, int totalCycleSec,
+                  int greenTimes[4], unsigned enabled) {
+    int giveDir = -1, giveRank = -1;
+    bool preempt = false;
+    for (int d = 0; d < 4; ++d) {
+        for (unsigned m = I.priority[d]; m; m &= m - 1) {
+            int cls = __builtin_ctz(m);
+            if (cls >= PRIO_CLASSES || policy.rank[cls] <= giveRank) continue;
+            giveDir = d;
+            giveRank = policy.rank[cls];
+            preempt = policy.preempt[cls];
+        }
+    }
+    if (giveDir < 0) return -1;
+    if (preempt) {
+        for (int d = 0; d < 4; ++d) greenTimes[d] = 0;
+        greenTimes[giveDir] = totalCycleSec;
+        return giveDir;
+    }
+    for (int s = 0; s < policy.extendSec; ++s) {
+        int from = -1;
+        for (int d = 0; d < 4; ++d)
+            if (d != giveDir && ((enabled >> d) & 1u) && greenTimes[d] > 0 && (from < 0 || greenTimes[d] > greenTimes[from]))
+                from = d;
+        if (from < 0) break;
+        greenTimes[from]--;
+        greenTimes[giveDir]++;
+    }
+    return giveDir;
+}
+
+static const PriorityPolicy kDefaultPriorityPolicy;
+
+// Green seconds for node i: caller plan or adaptive split, then priority requests.
+template <typename Inputs>
+static inline void decideGreens(const Inputs& in, Intersection& I, int i, const int* greenTimesIn, int greenTimes[4],
+                                const PriorityPolicy& policy) {
+    int cycleSec = in.cycleSec(i);
+    unsigned enabled = in.enabled(i);
+    if (greenTimesIn) {
+        for (int d = 0; d < 4; ++d) greenTimes[d] = max(0, greenTimesIn[i * 4 + d]);
+    } else {
+        allocateGreenTimes(I, cycleSec, greenTimes, enabled);
+    }
+
+    uint32_t masks;
+    memcpy(&masks, I.priority, sizeof masks);
+    int giveDir = masks ? applyPriority(I, policy, cycleSec, greenTimes, enabled) : -1;
+    if (giveDir >= 0) {
+        I.green_dir = giveDir;
+    } else {
+        int best = 0;
+        for (int d = 1; d < 4; ++d) if (greenTimes[d] > greenTimes[best]) best = d;
+        I.green_dir = best;
+    }
+}
+
+// Resolve the approach each link delivers into this cycle (approaches can be
+// closed between cycles), then move the vehicles whose travel time ends this
+// cycle into it. The storage check reads the same linkTarget.
+template <typename Inputs>
+static void mesoArrivals(MesoLinks& meso, vector<Intersection>& city, const Inputs& in, int cycle) {
+    int links = meso.linkTo.size();
+    for (int l = 0; l < links; ++l) {
+        int v = meso.linkTo[l];
+        unsigned enabled = in.enabled(v);
+        int d = meso.linkDir[l];
+        if (!((enabled >> d) & 1u)) d = enabled & 1u ? 0 : enabled & 2u ? 1 : enabled & 4u ? 2 : 3;
+        meso.linkTarget[l] = v * 4 + d;
+        int len = meso.offset[l + 1] - meso.offset[l];
+        int &slot = meso.slots[meso.offset[l] + cycle % len];
+        if (slot == 0) continue;
+        city[v].q[d] += slot;
+        meso.inTransit -= slot;
+        meso.linkLoad[l] -= slot;
+        slot = 0;
+    }
+}
+
+// Vehicles still on links towards each approach, and how many links share
+// each approach (a closed approach's traffic lands in another one).
+static void mesoInbound(MesoLinks& meso) {
+    fill(meso.inbound.begin(), meso.inbound.end(), 0);
+    fill(meso.feeders.begin(), meso.feeders.end(), 0);
+    int links = meso.linkTo.size();
+    for (int l = 0; l < links; ++l) {
+        int a = meso.linkTarget[l];
+        meso.inbound[a] += meso.linkLoad[l];
+        meso.feedRank[l] = meso.feeders[a]++;
+    }
+}
+
+// Optional engine features; the legacy uniform path leaves all of them off.
+struct CycleContext {
+    MesoLinks* meso = nullptr;
+    int cycle = 0;
+    const int* storage = nullptr;     // per approach; requires meso
+    ThreadPool* pool = nullptr;
+    int grain = 0;
+    CycleScratch* scratch = nullptr;
+    long long* blocked = nullptr;
+    const uint32_t* rateQ16 = nullptr;   // per approach; fixed-point service when set
+    uint32_t* credit = nullptr;
+    // Sparse priority bookkeeping; without it every mask is cleared each cycle.
+    const vector<PriorityRequest>* requests = nullptr;
+    vector<int>* priorityNodes = nullptr;
+    const PriorityPolicy* policy = &kDefaultPriorityPolicy;
+    int* greens = nullptr;               // per approach; receives the green seconds used
+    const int* cellOf = nullptr;         // masked grid: node -> cell for directions
+};
+
+template <typename F>
+static void forNodes(const CycleContext& ctx, int n, F&& body) {
+    if (ctx.pool) {
+        if (ctx.grain > 0) ctx.pool->parallelFor(n, ctx.grain, body);
+        else ctx.pool->parallelFor(n, body);
+    } else {
+        body(0, n);
+    }
+}
+
+template <typename Inputs>
+static void runCycle(vector<Intersection>& city, int C, const Inputs& in,
+                     const vector<int>& ambulancePath, uint64_t &rng, int &vehiclesArrivedTotal,
+                     long long &cumulativeQueueSum, long long &totalVehiclesServed,
+                     const int* greenTimesIn, const CycleContext& ctx)
+{
+    int n = city.size();
+    MesoLinks* meso = ctx.meso;
+    const int* storage = meso ? ctx.storage : nullptr;
+    int cycle = ctx.cycle;
+    if (meso) mesoArrivals(*meso, city, in, cycle);
+    if (storage) mesoInbound(*meso);
+    int maxArrivalPerLane = 5;
+    long long blocked = 0;
+    for (int i = 0; i < n; ++i) {
+        unsigned enabled = in.enabled(i);
+        for (int d = 0; d < 4; ++d) {
+            int arr = (nextRand(rng) % (maxArrivalPerLane + 1)) * ((enabled >> d) & 1u);
+            if (storage) {
+                // space left after the queue and the vehicles already on links into it
+                int room = storage[i * 4 + d] - city[i].q[d] - meso->inbound[i * 4 + d];
+                int admitted = max(0, min(arr, room));
+                blocked += arr - admitted;
+                arr = admitted;
+            }
+            city[i].q[d] += arr;
+            vehiclesArrivedTotal += arr;
+        }
+    }
+    if (ctx.blocked) *ctx.blocked += blocked;
+
+    vector<int>* touched = ctx.priorityNodes;
+    if (touched) {
+        for (int u : *touched) memset(city[u].priority, 0, sizeof city[u].priority);
+        touched->clear();
+    } else {
+        for (int i = 0; i < n; ++i) memset(city[i].priority, 0, sizeof city[i].priority);
+    }
+    auto request = [&](int u, int dir, int cls) {
+        uint8_t* p = city[u].priority;
+        if (touched && !(p[0] | p[1] | p[2] | p[3])) touched->push_back(u);
+        p[dir] |= (uint8_t)(1u << cls);
+    };
+    if (!ambulancePath.empty()) {
+        for (int idx = 0; idx + 1 < (int)ambulancePath.size(); ++idx) {
+            int u = ambulancePath[idx];
+            int v = ambulancePath[idx+1];
+            int dir = ctx.cellOf ? moveDirection(ctx.cellOf[u], ctx.cellOf[v], C) : moveDirection(u, v, C);
+            if (dir >= 0) request(u, dir, PRIO_AMBULANCE);
+        }
+    }
+    if (ctx.requests)
+        for (const auto& r : *ctx.requests)
+            if (r.node >= 0 && r.node < n && r.dir < 4 && r.cls < PRIO_CLASSES) request(r.node, r.dir, r.cls);
+
+    // Integer totals are order independent, so chunked accumulation gives
+    // the same result for any thread count.
+    atomic<long long> servedSum{0}, queueSum{0}, exitedSum{0}, transitSum{0};
+    auto depart = [&](int i, Intersection& I, const int served[4], long long& exited, long long& transit) {
+        for (int d = 0; d < 4; ++d) {
+            I.q[d] -= served[d];
+            if (!meso) continue;
+            int l = meso->linkOf[i * 4 + d];
+            if (l < 0) { exited += served[d]; continue; }
+            int len = meso->offset[l + 1] - meso->offset[l];
+            meso->slots[meso->offset[l] + cycle % len] += served[d];
+            meso->linkLoad[l] += served[d];
+            transit += served[d];
+        }
+    };
+    auto flush = [&](long long served, long long queued, long long exited, long long transit) {
+        servedSum += served; queueSum += queued; exitedSum += exited; transitSum += transit;
+    };
+
+    if (!storage) {
+        forNodes(ctx, n, [&](int b, int e) {
+            long long served = 0, queued = 0, exited = 0, transit = 0;
+            for (int i = b; i < e; ++i) {
+                Intersection &I = city[i];
+                int greenTimes[4], out[4];
+                decideGreens(in, I, i, greenTimesIn, greenTimes, *ctx.policy);
+                if (ctx.greens) memcpy(ctx.greens + i * 4, greenTimes, sizeof greenTimes);
+                if (ctx.rateQ16) {
+                    uint32_t* credit = ctx.credit + i * 4;
+                    accrueCredit(ctx.rateQ16 + i * 4, greenTimes, credit);
+                    for (int d = 0; d < 4; ++d) out[d] = min(I.q[d], (int)(credit[d] >> 16));
+                    settleCredit(out, credit);
+                } else {
+                    serviceDemand(in, i, I.q, greenTimes, out);
+                }
+                depart(i, I, out, exited, transit);
+                served += out[0] + out[1] + out[2] + out[3];
+                queued += I.q[0] + I.q[1] + I.q[2] + I.q[3];
+            }
+            flush(served, queued, exited, transit);
+        });
+    } else {
+        // Blocking-back in two phases. Phase 1 reads only a node's own state:
+        // how much each approach wants to discharge, and how much room each
+        // approach has left. Phase 2 limits every movement by the room of its
+        // receiving approach (linkTarget) taken from that snapshot. Usually one
+        // link feeds an approach; when a closed approach diverts another link
+        // into it, the room is split between its feeders in link order, so
+        // the outcome is still independent of node order and thread count.
+        vector<int> &demand = ctx.scratch->demand, &supply = ctx.scratch->supply;
+        demand.resize((size_t)n * 4);
+        supply.resize((size_t)n * 4);
+        forNodes(ctx, n, [&](int b, int e) {
+            for (int i = b; i < e; ++i) {
+                Intersection &I = city[i];
+                int greenTimes[4];
+                decideGreens(in, I, i, greenTimesIn, greenTimes, *ctx.policy);
+                if (ctx.greens) memcpy(ctx.greens + i * 4, greenTimes, sizeof greenTimes);
+                if (ctx.rateQ16) {
+                    uint32_t* credit = ctx.credit + i * 4;
+                    accrueCredit(ctx.rateQ16 + i * 4, greenTimes, credit);
+                    for (int d = 0; d < 4; ++d) demand[i * 4 + d] = min(I.q[d], (int)(credit[d] >> 16));
+                } else {
+                    serviceDemand(in, i, I.q, greenTimes, &demand[i * 4]);
+                }
+                for (int d = 0; d < 4; ++d)
+                    supply[i * 4 + d] = max(0, storage[i * 4 + d] - I.q[d] - meso->inbound[i * 4 + d]);
+            }
+        });
+        forNodes(ctx, n, [&](int b, int e) {
+            long long served = 0, queued = 0, exited = 0, transit = 0;
+            for (int i = b; i < e; ++i) {
+                Intersection &I = city[i];
+                int out[4];
+                for (int d = 0; d < 4; ++d) {
+                    int l = meso->linkOf[i * 4 + d];
+                    int room = INT_MAX;
+                    if (l >= 0) {
+                        int a = meso->linkTarget[l], k = meso->feeders[a];
+                        room = supply[a] / k + (meso->feedRank[l] < supply[a] % k);
+                    }
+                    out[d] = min(demand[i * 4 + d], room);
+                }
+                if (ctx.rateQ16) settleCredit(out, ctx.credit + i * 4);
+                depart(i, I, out, exited, transit);
+                served += out[0] + out[1] + out[2] + out[3];
+                queued += I.q[0] + I.q[1] + I.q[2] + I.q[3];
+            }
+            flush(served, queued, exited, transit);
+        });
+    }
+    totalVehiclesServed += servedSum;
+    cumulativeQueueSum += queueSum;
+    if (meso) { meso->exited += exitedSum; meso->inTransit += transitSum; }
+}
+
+// Simulate one cycle for all intersections with uniform timing
+void simulateCycle(vector<Intersection>& city, const vector<vector<Edge>>& graph,
+                   int R, int C,
+                   int totalCycleSec, double serviceRate,
+                   const vector<int>& ambulancePath, uint64_t &rng, int &vehiclesArrivedTotal,
+                   long long &cumulativeQueueSum, long long &totalVehiclesServed,
+                   const int* greenTimesIn)
+{
+    UniformInputs in = {totalCycleSec, (float)serviceRate};
+    runCycle(city, C, in, ambulancePath, rng, vehiclesArrivedTotal,
+             cumulativeQueueSum, totalVehiclesServed, greenTimesIn, CycleContext());
+}
+
+// Utility to print path nicely
+void printPath(ostream& out, const vector<int>& path, const string& label, const Simulation& sim) {
+    if (path.empty()) {
+        out << label << " No path found.\n";
+        return;
+    }
+    out << label << " Nodes: ";
+    for (int i = 0; i < (int)path.size(); ++i) {
+        out << path[i];
+        if (i + 1 < (int)path.size()) out << " -> ";
+    }
+    out << " | Coords: ";
+    for (int i = 0; i < (int)path.size(); ++i) {
+        int cell = nodeCell(sim, path[i]), r = cell / sim.C, c = cell % sim.C;
+        out << "(" << r << "," << c << ")";
+        if (i + 1 < (int)path.size()) out << " -> ";
+    }
+    out << "\n";
+}
+
+void initSimulation(Simulation& sim, const SimConfig& cfg) {
+    sim = Simulation();
+    sim.R = max(1, cfg.R);
+    sim.C = max(1, cfg.C);
+    sim.totalCycleSec = cfg.totalCycleSec;
+    sim.serviceRate = cfg.serviceRate;
+    sim.initialQueueMax = max(1, cfg.initialQueueMax);
+    buildGridGraph(sim.R, sim.C, sim.graph);
+
+    int n = sim.R * sim.C;
+    sim.city.assign(n, Intersection());
+    for (int i = 0; i < n; ++i) sim.city[i].id = i;
+    setUniformTiming(sim, sim.totalCycleSec, sim.serviceRate);
+    resetSimulation(sim, cfg.seed);
+}
+
+void setUniformTiming(Simulation& sim, int cycleSec, double serviceRate) {
+    int n = nodeCount(sim);
+    sim.totalCycleSec = cycleSec;
+    sim.serviceRate = serviceRate;
+    sim.params.cycleSec.assign(n, cycleSec);
+    sim.params.satFlow.assign((size_t)n * 4, (float)serviceRate);
+    sim.params.lanes.assign((size_t)n * 4, 1);
+    if (sim.grid.cellOf.empty() || (int)sim.params.enabled.size() != n) sim.params.enabled.assign(n, 0xF);
+}
+
+void recordGreens(Simulation& sim, bool on) {
+    if (on) sim.lastGreens.assign((size_t)nodeCount(sim) * 4, 0);
+    else sim.lastGreens.clear();
+}
+
+void enableMeso(Simulation& sim, int cyclesPerWeight) {
+    MesoLinks &m = sim.meso;
+    m = MesoLinks();
+    m.cyclesPerWeight = max(1, cyclesPerWeight);
+    int n = nodeCount(sim);
+    m.linkOf.assign((size_t)n * 4, -1);
+    m.offset.assign(1, 0);
+    for (int u = 0; u < n; ++u) {
+        for (auto &e : sim.graph[u]) {
+            int d = simDirection(sim, u, e.to);
+            if (d < 0) continue;
+            m.linkOf[u * 4 + d] = (int)m.linkTo.size();
+            m.linkTo.push_back(e.to);
+            m.linkDir.push_back((uint8_t)d);
+            m.offset.push_back(m.offset.back() + max(1, e.w * m.cyclesPerWeight));
+        }
+    }
+    m.slots.assign(m.offset.back(), 0);
+    m.linkLoad.assign(m.linkTo.size(), 0);
+    m.linkTarget.assign(m.linkTo.size(), 0);
+    m.feedRank.assign(m.linkTo.size(), 0);
+    m.inbound.assign((size_t)n * 4, 0);
+    m.feeders.assign((size_t)n * 4, 0);
+}
+
+void setStorageCapacity(Simulation& sim, int vehicles) {
+    if (sim.meso.cyclesPerWeight == 0) enableMeso(sim, 1);
+    sim.params.storage.assign((size_t)nodeCount(sim) * 4, max(0, vehicles));
+}
+
+void clearStorageCapacity(Simulation& sim) { sim.params.storage.clear(); }
+
+void enableFixedPointService(Simulation& sim) {
+    size_t k = sim.params.satFlow.size();
+    sim.params.rateQ16.resize(k);
+    for (size_t a = 0; a < k; ++a) {
+        double rate = (double)sim.params.satFlow[a] * sim.params.lanes[a];
+        sim.params.rateQ16[a] = (uint32_t)min(4294967295.0, max(0.0, floor(rate * 65536.0 + 0.5)));
+    }
+    sim.serviceCredit.assign(k, 0);
+}
+
+void disableFixedPointService(Simulation& sim) {
+    sim.params.rateQ16.clear();
+    sim.serviceCredit.clear();
+}
+
+void disableMeso(Simulation& sim) { sim.meso = MesoLinks(); }
+
+void resetSimulation(Simulation& sim, uint64_t seed) {
+    sim.rng = seed;
+    for (auto &I : sim.city) {
+        unsigned enabled = sim.params.enabled[I.id];
+        for (int d = 0; d < 4; ++d) {
+            I.q[d] = (nextRand(sim.rng) % sim.initialQueueMax) * ((enabled >> d) & 1u);
+            I.priority[d] = 0;
+        }
+        I.green_dir = -1;
+    }
+    sim.ambulancePath.clear();
+    sim.priorityRequests.clear();
+    sim.priorityNodes.clear();
+    fill(sim.meso.slots.begin(), sim.meso.slots.end(), 0);
+    fill(sim.meso.linkLoad.begin(), sim.meso.linkLoad.end(), 0);
+    sim.meso.inTransit = sim.meso.exited = 0;
+    sim.cycle = 0;
+    sim.vehiclesArrivedTotal = 0;
+    sim.cumulativeQueueSum = 0;
+    sim.totalVehiclesServed = 0;
+    sim.vehiclesBlocked = 0;
+    fill(sim.serviceCredit.begin(), sim.serviceCredit.end(), 0);
+}
+
+void stepWithGreens(Simulation& sim, const int* greenTimes) {
+    NodeInputs in = {sim.params};
+    CycleContext ctx;
+    ctx.meso = sim.meso.cyclesPerWeight > 0 ? &sim.meso : nullptr;
+    ctx.cycle = sim.cycle;
+    ctx.storage = sim.params.storage.empty() ? nullptr : sim.params.storage.data();
+    ctx.pool = sim.pool;
+    ctx.grain = sim.grain;
+    ctx.scratch = &sim.scratch;
+    ctx.blocked = &sim.vehiclesBlocked;
+    if (!sim.params.rateQ16.empty()) {
+        ctx.rateQ16 = sim.params.rateQ16.data();
+        ctx.credit = sim.serviceCredit.data();
+    }
+    ctx.requests = &sim.priorityRequests;
+    ctx.priorityNodes = &sim.priorityNodes;
+    ctx.policy = &sim.priorityPolicy;
+    if (!sim.lastGreens.empty()) ctx.greens = sim.lastGreens.data();
+    if (!sim.grid.cellOf.empty()) ctx.cellOf = sim.grid.cellOf.data();
+    runCycle(sim.city, sim.C, in, sim.ambulancePath, sim.rng, sim.vehiclesArrivedTotal,
+             sim.cumulativeQueueSum, sim.totalVehiclesServed, greenTimes, ctx);
+    sim.ambulancePath.clear();
+    sim.priorityRequests.clear();
+    ++sim.cycle;
+}
+
+void step(Simulation& sim, int n) {
+    for (int k = 0; k < n; ++k) stepWithGreens(sim, nullptr);
+}
+
+vector<int> route(const Simulation& sim, int src, int dest, bool leastCongested) {
+    int n = nodeCount(sim);
+    if (src < 0 || src >= n || dest < 0 || dest >= n) return {};
+    if (sim.altIndex && sim.altIndex->nodes == n) return altRoute(*sim.altIndex, sim, src, dest, leastCongested);
+    if (leastCongested) return dijkstraCongestionPath(src, dest, sim.graph, sim.city);
+    return dijkstraPath(src, dest, sim.graph);
+}
+
+vector<int> dispatchAmbulance(Simulation& sim, int src, int dest, bool leastCongested) {
+    sim.ambulancePath = route(sim, src, dest, leastCongested);
+    return sim.ambulancePath;
+}
+
+void requestPriority(Simulation& sim, PriorityClass cls, const vector<int>& path) {
+    for (size_t idx = 0; idx + 1 < path.size(); ++idx) {
+        int dir = simDirection(sim, path[idx], path[idx + 1]);
+        if (dir >= 0) sim.priorityRequests.push_back({path[idx], (uint8_t)dir, (uint8_t)cls});
+    }
+}
+
+vector<int> dispatchPriority(Simulation& sim, PriorityClass cls, int src, int dest, bool leastCongested) {
+    vector<int> path = route(sim, src, dest, leastCongested);
+    requestPriority(sim, cls, path);
+    return path;
+}
+
+void printNetworkRegion(ostream& out, const Simulation& sim, int r0, int c0, int r1, int c1) {
+    out << "\n=== Cycle " << sim.cycle << " Network State ===\n";
+    for (int r = r0; r <= r1; ++r) {
+        for (int c = c0; c <= c1; ++c) {
+            int id = cellNode(sim, nodeId(r, c, sim.C));
+            if (id < 0) {
+                out << "[  no intersection  ]  ";
+                continue;
+            }
+            const Intersection &I = sim.city[id];
+            out << "[Node " << id << "]";
+            out << " (N:" << I.q[0] << " S:" << I.q[1] << " E:" << I.q[2] << " W:" << I.q[3] << ")";
+            if (I.green_dir >= 0) out << " G:" << dirName(I.green_dir);
+            out << "  ";
+        }
+        out << "\n";
+    }
+    out << "==============================\n";
+}
+
+double averageQueueLength(const Simulation& sim) {
+    if (sim.cycle == 0 || sim.city.empty()) return 0.0;
+    return (double)sim.cumulativeQueueSum / ((double)sim.cycle * sim.city.size());
+}
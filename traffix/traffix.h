@@ -0,0 +1,325 @@
+// traffix.h
+// libtraffix: Smart Traffic Network Simulation as an embeddable library
+// (grid graph, adaptive local signals, ambulance priority).
+//
+// Build the static library:
+//   g++ -std=c++17 -O2 -pthread -c traffix/*.cpp && ar rcs libtraffix.a *.o
+// Link an application against it:
+//   g++ -std=c++17 -O2 -pthread app.cpp -L. -ltraffix -o app
+//
+// C applications use the opaque-handle API in traffix_c.h instead.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+struct Edge { int to; int w; };
+
+// Priority vehicle classes. Bit k of an approach's priority mask is set
+// while a vehicle of class k requests that approach this cycle.
+enum PriorityClass {
+    PRIO_FIRE = 0,
+    PRIO_AMBULANCE,
+    PRIO_POLICE,
+    PRIO_TRANSIT,
+    PRIO_FREIGHT,
+    PRIO_CLASSES
+};
+
+struct Intersection {
+    int id;
+    // queue length for each direction: 0=N,1=S,2=E,3=W
+    int q[4] = {0,0,0,0};
+    // which direction currently green (for printing) - -1 = none (during cycle output)
+    int green_dir = -1;
+    // priority requests this cycle per direction, bit k = PriorityClass k
+    uint8_t priority[4] = {0,0,0,0};
+};
+
+extern const int dr[4]; // N S E W
+extern const int dc[4];
+std::string dirName(int d);
+
+// Convert (r,c) to node id
+inline int nodeId(int r, int c, int C) { return r * C + c; }
+
+// Direction (0=N,1=S,2=E,3=W) of the move u -> v between grid neighbours,
+// -1 if they are not adjacent.
+inline int moveDirection(int u, int v, int C) {
+    int ur = u / C, uc = u % C;
+    int vr = v / C, vc = v % C;
+    if (vr == ur - 1 && vc == uc) return 0;
+    if (vr == ur + 1 && vc == uc) return 1;
+    if (vr == ur && vc == uc + 1) return 2;
+    if (vr == ur && vc == uc - 1) return 3;
+    return -1;
+}
+
+// Small deterministic generator so every simulation owns its random stream
+// (splitmix64). Returns 32 uniformly distributed bits.
+inline uint32_t nextRand(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+// Read-only, non-owning view over simulation state. Valid until the
+// simulation is stepped with a different grid or destroyed.
+template <typename T>
+struct Span {
+    const T* ptr = nullptr;
+    size_t len = 0;
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + len; }
+    const T* data() const { return ptr; }
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+};
+
+// ---- Building blocks ----
+
+std::vector<int> dijkstraPath(int src, int dest, const std::vector<std::vector<Edge>>& graph);
+// Cost of entering intersection I on a least-congested route: 1 plus its
+// total queue / 5. Every congestion-aware search (Dijkstra, ALT, the
+// congestion pyramid) uses this one definition so their costs agree.
+inline int congestionWeight(const Intersection& I) { return 1 + (I.q[0] + I.q[1] + I.q[2] + I.q[3]) / 5; }
+std::vector<int> dijkstraCongestionPath(int src, int dest, const std::vector<std::vector<Edge>>& graph,
+                                        const std::vector<Intersection>& city);
+void buildGridGraph(int R, int C, std::vector<std::vector<Edge>>& graph);
+std::vector<int> allocateGreenTimes(const Intersection &I, int totalCycleSec);
+// Allocation-free variant writing into times[4]; approaches whose bit is
+// clear in `enabled` get no green.
+void allocateGreenTimes(const Intersection &I, int totalCycleSec, int times[4], unsigned enabled = 0xF);
+// Proportional split kernel shared by every engine (grid, junction, lane and
+// cluster models), so they all round the same way. demand[k] < 0 marks an
+// entry that gets no green. With any demand, each active entry gets at least
+// 1 s and otherwise its share of T rounded half up (exact integer
+// arithmetic); surplus is taken from the smallest demands and shortfall
+// given to the largest. Without demand T is shared evenly, the remainder
+// going to the first active entry.
+void splitGreenTimes(const int* demand, int n, int T, int* times);
+// Q16.16 service shared by every engine: accrue rateQ16 (vehicles per second)
+// for `seconds` of green, saturating, then settle once `served` vehicles
+// have left. Whole vehicles of capacity that went unused (queue emptied or
+// blocked downstream) are dropped; only the fraction carries over.
+inline uint32_t accrueCredit(uint32_t credit, uint32_t rateQ16, uint32_t seconds) {
+    uint64_t acc = credit + (uint64_t)rateQ16 * seconds;
+    return acc > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)acc;
+}
+inline uint32_t settleCredit(uint32_t credit, int served) {
+    uint32_t left = credit - ((uint32_t)served << 16);
+    return (uint32_t)served < (credit >> 16) ? (left & 0xFFFFu) : left;
+}
+// Both steps for one approach holding q vehicles; returns the vehicles served.
+inline int serveCredit(uint32_t& credit, uint32_t rateQ16, uint32_t seconds, int q) {
+    credit = accrueCredit(credit, rateQ16, seconds);
+    int out = (uint32_t)q < (credit >> 16) ? q : (int)(credit >> 16);
+    credit = settleCredit(credit, out);
+    return out;
+}
+// Split totalCycleSec by caller-supplied fractions (largest remainder, so the
+// result always sums to totalCycleSec). Non-positive splits get no green.
+void greenTimesFromSplits(const float splits[4], int totalCycleSec, int times[4], unsigned enabled = 0xF);
+// Conflict resolution between priority requests at one intersection: the
+// request of the highest-ranked class wins (lowest direction on a tie).
+// Preempting classes take the whole cycle for their approach; the others
+// get their green extended by up to extendSec, taken from the longest
+// competing greens.
+struct PriorityPolicy {
+    uint8_t rank[PRIO_CLASSES] = {5, 4, 3, 2, 1};
+    bool preempt[PRIO_CLASSES] = {true, true, true, false, false};
+    int extendSec = 10;
+};
+// Apply I.priority to greenTimes. Returns the winning direction, -1 if none.
+int applyPriority(const Intersection &I, const PriorityPolicy &policy, int totalCycleSec,
+                  int greenTimes[4], unsigned enabled = 0xF);
+// A class requesting the approach of `node` in direction `dir`.
+struct PriorityRequest { int node; uint8_t dir; uint8_t cls; };
+
+// greenTimes, if given, holds n*4 green seconds that replace the adaptive
+// allocation (ambulance priority still wins).
+void simulateCycle(std::vector<Intersection>& city, const std::vector<std::vector<Edge>>& graph,
+                   int R, int C,
+                   int totalCycleSec, double serviceRate,
+                   const std::vector<int>& ambulancePath, uint64_t &rng, int &vehiclesArrivedTotal,
+                   long long &cumulativeQueueSum, long long &totalVehiclesServed,
+                   const int* greenTimes = nullptr);
+
+// ---- Simulation handle ----
+
+struct SimConfig {
+    int R = 2, C = 2;
+    int totalCycleSec = 30;
+    double serviceRate = 0.5;   // vehicles per second when green
+    uint64_t seed = 1;
+    int initialQueueMax = 20;   // initial queues drawn from [0, initialQueueMax)
+};
+
+// Per-intersection timing and capacity, structure-of-arrays. Approach arrays
+// are indexed node * 4 + d. Uniform grids simply hold the same value
+// everywhere; the cycle kernels read these arrays in both cases.
+struct NodeParams {
+    std::vector<int> cycleSec;       // per node
+    std::vector<float> satFlow;      // vehicles per second per lane when green
+    std::vector<uint8_t> lanes;      // lanes per approach
+    std::vector<uint8_t> enabled;    // per node, bit d set = approach d exists
+    std::vector<int> storage;        // vehicles an approach can hold; empty = unlimited
+    std::vector<uint32_t> rateQ16;   // fixed-point service rate (Q16.16); empty = float model
+};
+
+// Mesoscopic links: every edge u -> v is a delay line of
+// max(1, w * cyclesPerWeight) cycles. Vehicles served from approach d at u
+// enter the link leaving u in direction d and emerge at v's approach d
+// (straight on; the first enabled approach if d is closed) after the travel
+// time. Vehicles served towards the grid boundary leave the network. All
+// delay lines share one pooled slot array; slot (cycle % length) of a link
+// is read at the start of a cycle and refilled by that cycle's departures,
+// so no per-link head pointer is needed.
+struct MesoLinks {
+    int cyclesPerWeight = 0;        // 0 = mode disabled
+    std::vector<int> linkOf;        // node*4 + d -> link id or -1
+    std::vector<int> linkTo;        // per link
+    std::vector<uint8_t> linkDir;   // per link
+    std::vector<int> linkTarget;    // per link: receiving approach (node*4 + d), refreshed every cycle
+    // Storage bookkeeping, refreshed every cycle when a capacity is set.
+    std::vector<int> inbound;       // per approach: vehicles on links delivering into it
+    std::vector<int> feeders;       // per approach: links delivering into it
+    std::vector<int> feedRank;      // per link: position among its approach's feeders
+    std::vector<int> offset;        // links + 1 entries into slots
+    std::vector<int> slots;
+    std::vector<int> linkLoad;      // vehicles currently on each link
+    long long inTransit = 0;
+    long long exited = 0;           // served towards the boundary
+};
+
+// Reused per-cycle buffers (two-phase serve pass).
+struct CycleScratch {
+    std::vector<int> demand, supply;
+};
+
+class ThreadPool;
+struct AltIndex;
+
+// Masked grids: only the cells whose bit is set are intersections, numbered
+// densely in row-major order. cellOf maps node -> cell (select); cellNode()
+// maps back through a rank directory (set bits before each 64-cell word plus
+// a popcount). All empty on a full grid, where node id == cell id.
+struct GridIndex {
+    std::vector<uint64_t> bits;
+    std::vector<uint32_t> rank;
+    std::vector<int> cellOf;
+};
+
+struct Simulation {
+    int R = 0, C = 0;
+    int totalCycleSec = 30;
+    double serviceRate = 0.5;
+    GridIndex grid;
+    std::vector<std::vector<Edge>> graph;
+    std::vector<Intersection> city;
+    NodeParams params;
+    MesoLinks meso;
+    // Ambulance route applied to the next step only, then cleared.
+    std::vector<int> ambulancePath;
+    // Further priority requests for the next step only. Masks are set and
+    // cleared through these sparse lists, so a cycle costs O(requests).
+    std::vector<PriorityRequest> priorityRequests;
+    std::vector<int> priorityNodes;   // nodes whose masks are currently set
+    PriorityPolicy priorityPolicy;
+    // Green seconds per approach (node * 4 + d) used in the last cycle; only
+    // kept while recordGreens is on.
+    std::vector<int> lastGreens;
+    uint64_t rng = 1;
+    int initialQueueMax = 20;
+
+    int cycle = 0;   // completed cycles
+    int vehiclesArrivedTotal = 0;
+    long long cumulativeQueueSum = 0;
+    long long totalVehiclesServed = 0;
+    long long vehiclesBlocked = 0;   // arrivals refused for lack of storage
+
+    // Optional worker pool for the per-node passes (not owned). Results are
+    // identical with or without it. grain = nodes per task, 0 = automatic.
+    ThreadPool* pool = nullptr;
+    int grain = 0;
+    CycleScratch scratch;
+    // Fractional service carried between cycles (Q16.16, always < 1 vehicle).
+    std::vector<uint32_t> serviceCredit;
+    // Optional ALT landmark index (alt.h, not owned). When set and built for
+    // this graph, route() runs goal-directed A* instead of plain Dijkstra;
+    // path costs are the same.
+    const AltIndex* altIndex = nullptr;
+};
+
+void initSimulation(Simulation& sim, const SimConfig& cfg);
+// Reset every node to the given cycle length, one lane per approach at
+// serviceRate, all four approaches enabled (on a masked grid the approaches
+// keep the mask's roads).
+void setUniformTiming(Simulation& sim, int cycleSec, double serviceRate);
+// Keep lastGreens up to date on every step (on) or stop recording (off).
+void recordGreens(Simulation& sim, bool on);
+// Switch the mesoscopic link model on (travel time w * cyclesPerWeight
+// cycles per edge) or off. Enabling empties all links.
+void enableMeso(Simulation& sim, int cyclesPerWeight = 1);
+void disableMeso(Simulation& sim);
+// Limit every approach to `vehicles` (queue plus vehicles on the link
+// feeding it). Discharge is then capped by the room left downstream, so
+// saturation spills back upstream. Enables the mesoscopic links if needed.
+void setStorageCapacity(Simulation& sim, int vehicles);
+void clearStorageCapacity(Simulation& sim);
+// Switch to integer Q16.16 service: rateQ16 is derived from satFlow * lanes
+// (call again after changing them) and the fractional vehicle left at the
+// end of each green carries into the next one instead of being rounded away.
+void enableFixedPointService(Simulation& sim);
+void disableFixedPointService(Simulation& sim);
+// Redraw the initial queues from a new seed and zero the statistics, reusing
+// the existing graph and buffers (no allocation).
+void resetSimulation(Simulation& sim, uint64_t seed);
+// Run n cycles. A pending ambulance route is honoured by the first of them.
+void step(Simulation& sim, int n = 1);
+// Run one cycle with caller-chosen green seconds (n*4, see simulateCycle).
+void stepWithGreens(Simulation& sim, const int* greenTimes);
+// Route without dispatching.
+std::vector<int> route(const Simulation& sim, int src, int dest, bool leastCongested = false);
+// Route an ambulance and give it priority on the next step. Returns the path
+// (empty if src/dest are invalid or unreachable).
+std::vector<int> dispatchAmbulance(Simulation& sim, int src, int dest, bool leastCongested = false);
+// Queue priority for a vehicle of class cls along path on the next step.
+void requestPriority(Simulation& sim, PriorityClass cls, const std::vector<int>& path);
+// Route a priority vehicle and request priority along it. Returns the path.
+std::vector<int> dispatchPriority(Simulation& sim, PriorityClass cls, int src, int dest,
+                                  bool leastCongested = false);
+
+inline int nodeCount(const Simulation& sim) { return (int)sim.city.size(); }
+inline int nodeCell(const Simulation& sim, int u) { return sim.grid.cellOf.empty() ? u : sim.grid.cellOf[u]; }
+// Node at grid cell r * C + c, -1 if the mask has no intersection there.
+inline int cellNode(const Simulation& sim, int cell) {
+    if (sim.grid.cellOf.empty()) return cell;
+    uint64_t word = sim.grid.bits[cell >> 6], bit = 1ull << (cell & 63);
+    if (!(word & bit)) return -1;
+    return (int)sim.grid.rank[cell >> 6] + __builtin_popcountll(word & (bit - 1));
+}
+// moveDirection for node ids of this simulation.
+inline int simDirection(const Simulation& sim, int u, int v) {
+    return moveDirection(nodeCell(sim, u), nodeCell(sim, v), sim.C);
+}
+inline Span<Intersection> intersections(const Simulation& sim) {
+    return {sim.city.data(), sim.city.size()};
+}
+inline Span<int> pendingAmbulancePath(const Simulation& sim) {
+    return {sim.ambulancePath.data(), sim.ambulancePath.size()};
+}
+double averageQueueLength(const Simulation& sim);
+// One line per grid row; masked cells are skipped, ids are node ids.
+void printNetworkState(std::ostream& out, const Simulation& sim, int cycle);
+// Node ids followed by their grid coordinates.
+void printPath(std::ostream& out, const std::vector<int>& path, const std::string& label, const Simulation& sim);
+// Rows r0..r1 and columns c0..c1 (inclusive) in the printNetworkState
+// format; cells without an intersection are left blank.
+void printNetworkRegion(std::ostream& out, const Simulation& sim, int r0, int c0, int r1, int c1);
@@ -0,0 +1,83 @@
+// traffix_c.cpp
+// C binding: thin wrappers over the Simulation API.
+
+#include "traffix_c.h"
+#include "traffix.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+using namespace std;
+
+struct traffix_sim { Simulation sim; };
+
+static_assert(sizeof(Intersection) % sizeof(int) == 0, "queue stride must be a whole number of ints");
+static const int kIntersectionStride = (int)(sizeof(Intersection) / sizeof(int));
+
+extern "C" {
+
+int traffix_api_version(void) { return TRAFFIX_API_VERSION; }
+
+traffix_sim* traffix_create(int rows, int cols, int cycle_sec, double service_rate,
+                            unsigned long long seed) {
+    if (rows <= 0 || cols <= 0 || cycle_sec <= 0 || service_rate < 0) return nullptr;
+    traffix_sim* h = new (nothrow) traffix_sim;
+    if (!h) return nullptr;
+    SimConfig cfg;
+    cfg.R = rows; cfg.C = cols;
+    cfg.totalCycleSec = cycle_sec;
+    cfg.serviceRate = service_rate;
+    cfg.seed = seed;
+    initSimulation(h->sim, cfg);
+    return h;
+}
+
+void traffix_destroy(traffix_sim* sim) { delete sim; }
+
+void traffix_step(traffix_sim* sim, int cycles) {
+    if (sim && cycles > 0) step(sim->sim, cycles);
+}
+
+int traffix_rows(const traffix_sim* sim) { return sim ? sim->sim.R : 0; }
+int traffix_cols(const traffix_sim* sim) { return sim ? sim->sim.C : 0; }
+int traffix_node_count(const traffix_sim* sim) { return sim ? nodeCount(sim->sim) : 0; }
+
+int traffix_route(const traffix_sim* sim, int src, int dest, int least_congested,
+                  int* out_nodes, int capacity) {
+    if (!sim) return 0;
+    vector<int> path = route(sim->sim, src, dest, least_congested != 0);
+    int len = (int)path.size();
+    if (out_nodes && capacity > 0)
+        memcpy(out_nodes, path.data(), sizeof(int) * (size_t)min(len, capacity));
+    return len;
+}
+
+int traffix_dispatch_ambulance(traffix_sim* sim, int src, int dest, int least_congested) {
+    if (!sim) return 0;
+    return (int)dispatchAmbulance(sim->sim, src, dest, least_congested != 0).size();
+}
+
+const int* traffix_queues(const traffix_sim* sim, int* stride) {
+    if (stride) *stride = kIntersectionStride;
+    if (!sim || sim->sim.city.empty()) return nullptr;
+    return sim->sim.city[0].q;
+}
+
+const int* traffix_green_dirs(const traffix_sim* sim, int* stride) {
+    if (stride) *stride = kIntersectionStride;
+    if (!sim || sim->sim.city.empty()) return nullptr;
+    return &sim->sim.city[0].green_dir;
+}
+
+void traffix_get_stats(const traffix_sim* sim, traffix_stats* out) {
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!sim) return;
+    out->cycle = sim->sim.cycle;
+    out->vehicles_arrived = sim->sim.vehiclesArrivedTotal;
+    out->vehicles_served = sim->sim.totalVehiclesServed;
+    out->cumulative_queue_sum = sim->sim.cumulativeQueueSum;
+}
+
+} // extern "C"
@@ -0,0 +1,56 @@
+/* traffix_c.h
+ * Stable C interface to libtraffix. The simulation is an opaque handle;
+ * state is read in place through the pointers returned below (no copies,
+ * no text parsing). Pointers stay valid until the next traffix_step or
+ * traffix_destroy on the same handle.
+ */
+#ifndef TRAFFIX_C_H
+#define TRAFFIX_C_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TRAFFIX_API_VERSION 1
+
+typedef struct traffix_sim traffix_sim;
+
+typedef struct traffix_stats {
+    int cycle;                      /* completed cycles */
+    long long vehicles_arrived;
+    long long vehicles_served;
+    long long cumulative_queue_sum;
+} traffix_stats;
+
+int traffix_api_version(void);
+
+/* Returns NULL on invalid arguments. */
+traffix_sim* traffix_create(int rows, int cols, int cycle_sec, double service_rate,
+                            unsigned long long seed);
+void traffix_destroy(traffix_sim* sim);
+
+void traffix_step(traffix_sim* sim, int cycles);
+
+int traffix_rows(const traffix_sim* sim);
+int traffix_cols(const traffix_sim* sim);
+int traffix_node_count(const traffix_sim* sim);
+
+/* Compute a route into out_nodes (up to capacity entries). Returns the full
+ * path length, 0 if unreachable or the ids are out of range. */
+int traffix_route(const traffix_sim* sim, int src, int dest, int least_congested,
+                  int* out_nodes, int capacity);
+/* Route an ambulance that gets priority on the next step. Returns path length. */
+int traffix_dispatch_ambulance(traffix_sim* sim, int src, int dest, int least_congested);
+
+/* Queue of node i, direction d (0=N,1=S,2=E,3=W) is queues[i * stride + d].
+ * Green direction of node i is green_dirs[i * stride] (-1 = none). */
+const int* traffix_queues(const traffix_sim* sim, int* stride);
+const int* traffix_green_dirs(const traffix_sim* sim, int* stride);
+
+void traffix_get_stats(const traffix_sim* sim, traffix_stats* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TRAFFIX_C_H */
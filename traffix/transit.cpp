@@ -0,0 +1,114 @@
+// transit.cpp
+
+#include "transit.h"
+
+#include <algorithm>
+
+using namespace std;
+
+static void enqueue(TransitSystem& ts, int bus) {
+    const int H = ts.buckets.size();
+    ts.buckets[ts.buses[bus].due % H].push_back(bus);
+}
+
+void initTransit(TransitSystem& ts, int horizon) {
+    ts = TransitSystem();
+    ts.buckets.resize(max(1, horizon));
+}
+
+int addTransitRoute(TransitSystem& ts, const Simulation& sim, const vector<int>& path, int firstDeparture,
+                    int headway, int trips, int cyclesPerHop) {
+    const int n = nodeCount(sim);
+    for (size_t k = 0; k < path.size(); ++k) {
+        if (path[k] < 0 || path[k] >= n) return -1;
+        if (k > 0 && simDirection(sim, path[k - 1], path[k]) < 0) return -1;
+    }
+    TransitRoute r;
+    r.path = path;
+    for (size_t k = 0; k < path.size(); ++k) r.offsets.push_back((int)k * cyclesPerHop);
+    for (int t = 0; t < trips; ++t) r.departures.push_back(firstDeparture + t * headway);
+    ts.routes.push_back(r);
+    int id = ts.routes.size() - 1;
+    if (path.size() < 2) return id;
+    for (int dep : ts.routes[id].departures) {
+        TransitBus b;
+        b.route = id;
+        b.depart = dep;
+        b.due = max(dep, sim.cycle);   // already departed: first evaluated now, lateness shows the delay
+        b.ahead = -1;   // joins the queue when first evaluated
+        ts.buses.push_back(b);
+        enqueue(ts, ts.buses.size() - 1);
+    }
+    return id;
+}
+
+void transitStep(TransitSystem& ts, Simulation& sim, int n) {
+    if (sim.lastGreens.empty()) recordGreens(sim, true);
+    const int H = ts.buckets.size();
+    vector<int> due;
+    vector<uint32_t> creditBefore;   // fixed-point service: credit of each due bus's approach
+    for (int k = 0; k < n; ++k) {
+        int now = sim.cycle;
+        vector<int>& bucket = ts.buckets[now % H];
+        due.clear();
+        size_t keep = 0;
+        for (int b : bucket) {
+            if (ts.buses[b].due == now) due.push_back(b);
+            else bucket[keep++] = b;   // a later lap of the calendar
+        }
+        bucket.resize(keep);
+        creditBefore.assign(due.size(), 0);
+
+        bool fixedPoint = !sim.params.rateQ16.empty();
+        for (size_t j = 0; j < due.size(); ++j) {
+            TransitBus& bus = ts.buses[due[j]];
+            const TransitRoute& r = ts.routes[bus.route];
+            int u = r.path[bus.idx];
+            int dir = simDirection(sim, u, r.path[bus.idx + 1]);
+            if (dir < 0) continue;   // not a road; moved on below
+            if (fixedPoint) creditBefore[j] = sim.serviceCredit[u * 4 + dir];
+            if (bus.ahead < 0) bus.ahead = sim.city[u].q[dir];
+            if (now - (bus.depart + r.offsets[bus.idx]) >= ts.lateThreshold) {
+                sim.priorityRequests.push_back({u, (uint8_t)dir, (uint8_t)PRIO_TRANSIT});
+                ++ts.requests;
+                if (sim.city[u].green_dir == dir) ++ts.extensions;
+                else ++ts.earlyGreens;
+            }
+        }
+
+        step(sim);
+
+        for (size_t j = 0; j < due.size(); ++j) {
+            int b = due[j];
+            TransitBus& bus = ts.buses[b];
+            const TransitRoute& r = ts.routes[bus.route];
+            int u = r.path[bus.idx];
+            int dir = simDirection(sim, u, r.path[bus.idx + 1]);
+            if (dir < 0) {
+                bus.ahead = -1;   // hop is not a road (grid changed under the route)
+            } else {
+                // Green capacity computed exactly as the engine served it.
+                int a = u * 4 + dir;
+                if (fixedPoint)
+                    bus.ahead -= (int)(accrueCredit(creditBefore[j], sim.params.rateQ16[a], (uint32_t)sim.lastGreens[a]) >> 16);
+                else
+                    bus.ahead -= (int)(sim.params.satFlow[a] * sim.params.lanes[a] * sim.lastGreens[a] + 1e-4f);
+            }
+            bus.due = now + 1;
+            if (bus.ahead < 0) {
+                // Through the junction; the next node is reached one cycle later.
+                bus.ahead = -1;
+                if (++bus.idx + 1 >= (int)r.path.size()) {
+                    ++ts.tripsCompleted;
+                    ts.totalLateness += max(0, bus.due - (bus.depart + r.offsets[bus.idx]));
+                    continue;
+                }
+            }
+            enqueue(ts, b);
+        }
+    }
+}
+
+double averageLateness(const TransitSystem& ts) {
+    return ts.tripsCompleted ? (double)ts.totalLateness / ts.tripsCompleted : 0.0;
+}
@@ -0,0 +1,60 @@
+// transit.h
+// Scheduled bus routes with conditional transit signal priority (TSP).
+//
+// A route is a node path with a timetable: trip departures (cycle numbers)
+// and the scheduled cycle offset at every node along the path. A bus joins
+// the back of its approach's queue at each node and clears the node once
+// the green capacity of that approach has discharged the vehicles ahead of
+// it. A bus running at least lateThreshold cycles behind its timetable asks
+// for PRIO_TRANSIT on its approach; under the Simulation's PriorityPolicy
+// that extends the green (if the approach already held the longest green,
+// counted as an extension) or brings green forward to it (early green).
+//
+// Buses are kept in a calendar of per-cycle buckets (bucket = due cycle mod
+// horizon), so each cycle only the buses due at an intersection that cycle
+// are looked at, however many are in service.
+
+#pragma once
+
+#include "traffix.h"
+
+#include <vector>
+
+struct TransitRoute {
+    std::vector<int> path;        // consecutive grid neighbours
+    std::vector<int> offsets;     // scheduled cycle at path[k] relative to departure
+    std::vector<int> departures;  // trip start cycles
+};
+
+struct TransitBus {
+    int route = 0;
+    int depart = 0;               // cycle the trip starts
+    int idx = 0;                  // position along the route path
+    int due = 0;                  // cycle of the next evaluation
+    int ahead = 0;                // vehicles queued in front of the bus
+};
+
+struct TransitSystem {
+    int lateThreshold = 1;        // cycles behind schedule before priority is asked for
+    std::vector<TransitRoute> routes;
+    std::vector<TransitBus> buses;
+    std::vector<std::vector<int>> buckets;   // bus ids by due cycle % horizon
+
+    long long tripsCompleted = 0;
+    long long totalLateness = 0;  // cycles behind schedule at the terminus, summed
+    long long requests = 0, extensions = 0, earlyGreens = 0;
+};
+
+// horizon: calendar length in cycles; events further ahead wrap around and
+// are skipped until their cycle comes up.
+void initTransit(TransitSystem& ts, int horizon = 256);
+// Add a route served every headway cycles from firstDeparture (trips times),
+// scheduled cyclesPerHop cycles between consecutive nodes. Returns its index,
+// or -1 (nothing added) if the path leaves the grid or a hop is not between
+// neighbours.
+int addTransitRoute(TransitSystem& ts, const Simulation& sim, const std::vector<int>& path, int firstDeparture,
+                    int headway, int trips, int cyclesPerHop = 1);
+// Run n cycles: request priority for late buses, step the simulation and
+// move the buses. Turns recordGreens on for the simulation.
+void transitStep(TransitSystem& ts, Simulation& sim, int n = 1);
+double averageLateness(const TransitSystem& ts);
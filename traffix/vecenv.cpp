@@ -0,0 +1,78 @@
+// vecenv.cpp
+
+#include "vecenv.h"
+
+#include <algorithm>
+
+using namespace std;
+
+static uint64_t envSeed(uint64_t base, int b, uint64_t episode) {
+    uint64_t s = base ^ (0xD1B54A32D192ED03ull * (uint64_t)(b + 1));
+    s += 0x9E3779B97F4A7C15ull * episode;
+    nextRand(s);
+    return s;
+}
+
+static void writeObs(const Simulation& sim, int32_t* out) {
+    for (const Intersection &I : sim.city)
+        for (int d = 0; d < 4; ++d) *out++ = I.q[d];
+}
+
+static float queueReward(const Simulation& sim) {
+    long long total = 0;
+    for (const Intersection &I : sim.city) total += I.q[0] + I.q[1] + I.q[2] + I.q[3];
+    return -(float)total;
+}
+
+void initVecEnv(VecEnv& env, const SimConfig& cfg, int B, int episodeCycles, int threads) {
+    env.B = max(0, B);
+    env.episodeCycles = max(0, episodeCycles);
+    env.baseSeed = cfg.seed;
+    env.envs.assign(env.B, Simulation());
+    env.episode.assign(env.B, 0);
+    for (int b = 0; b < env.B; ++b) {
+        SimConfig c = cfg;
+        c.seed = envSeed(cfg.seed, b, 0);
+        initSimulation(env.envs[b], c);
+    }
+    env.nodes = env.B > 0 ? nodeCount(env.envs[0]) : 0;
+    env.greenScratch.assign((size_t)env.B * env.nodes * 4, 0);
+    env.pool.reset(new ThreadPool(threads));
+}
+
+void vecEnvReset(VecEnv& env, int32_t* obs) {
+    size_t stride = (size_t)env.nodes * 4;
+    env.pool->parallelFor(env.B, 1, [&](int b0, int b1) {
+        for (int b = b0; b < b1; ++b) {
+            env.episode[b]++;
+            resetSimulation(env.envs[b], envSeed(env.baseSeed, b, env.episode[b]));
+            if (obs) writeObs(env.envs[b], obs + b * stride);
+        }
+    });
+}
+
+void vecEnvStep(VecEnv& env, const float* actions, int32_t* obs, float* rewards, uint8_t* dones) {
+    size_t stride = (size_t)env.nodes * 4;
+    env.pool->parallelFor(env.B, 1, [&](int b0, int b1) {
+        for (int b = b0; b < b1; ++b) {
+            Simulation &sim = env.envs[b];
+            const int* greens = nullptr;
+            if (actions) {
+                int* g = env.greenScratch.data() + b * stride;
+                const float* a = actions + b * stride;
+                for (int i = 0; i < env.nodes; ++i)
+                    greenTimesFromSplits(a + i * 4, sim.params.cycleSec[i], g + i * 4, sim.params.enabled[i]);
+                greens = g;
+            }
+            stepWithGreens(sim, greens);
+            if (rewards) rewards[b] = queueReward(sim);
+            bool done = env.episodeCycles > 0 && sim.cycle >= env.episodeCycles;
+            if (done) {
+                env.episode[b]++;
+                resetSimulation(sim, envSeed(env.baseSeed, b, env.episode[b]));
+            }
+            if (dones) dones[b] = done ? 1 : 0;
+            if (obs) writeObs(sim, obs + b * stride);
+        }
+    });
+}
@@ -0,0 +1,37 @@
+// vecenv.h
+// Batched environment for reinforcement-learning signal control: B
+// independent cities advanced in lockstep on a thread pool.
+//
+// Tensors are caller-owned and row-major:
+//   obs     int32 [B][nodes][4]  queue per approach after the step
+//   actions float [B][nodes][4]  green splits replacing allocateGreenTimes
+//                                (nullptr = adaptive allocation)
+//   rewards float [B]            minus the total queued vehicles
+//   dones   uint8 [B]            1 when the episode ended; that env was reset
+// Stepping performs no heap allocation.
+
+#pragma once
+
+#include "parallel.h"
+#include "traffix.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct VecEnv {
+    int B = 0;
+    int nodes = 0;
+    int episodeCycles = 0;       // 0 = never end episodes
+    uint64_t baseSeed = 1;
+    std::vector<Simulation> envs;
+    std::vector<uint64_t> episode;   // per env, used to derive reset seeds
+    std::vector<int> greenScratch;   // B * nodes * 4
+    std::unique_ptr<ThreadPool> pool;
+};
+
+// cfg describes one city; env b is seeded from cfg.seed and b.
+void initVecEnv(VecEnv& env, const SimConfig& cfg, int B, int episodeCycles = 0, int threads = 0);
+inline int vecEnvObsSize(const VecEnv& env) { return env.nodes * 4; }
+void vecEnvReset(VecEnv& env, int32_t* obs);
+void vecEnvStep(VecEnv& env, const float* actions, int32_t* obs, float* rewards, uint8_t* dones);